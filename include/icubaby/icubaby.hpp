@@ -67,9 +67,13 @@
 #include <cstdint>
 #include <iterator>
 #include <limits>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 /// \brief ICUBABY_CXX20 has value 1 when compiling with C++ 20 or later and 0
 ///   otherwise.
@@ -85,7 +89,9 @@
 #define ICUBABY_CXX20 (0)
 #endif
 
-#ifndef ICUBABY_CXX20
+// <version> supplies the library feature-test macros (such as __cpp_lib_ranges)
+// which are used below. It is only available from C++ 20.
+#if ICUBABY_CXX20
 #include <version>
 #endif
 
@@ -101,6 +107,40 @@
 #include <ranges>
 #endif
 
+#ifdef __cpp_impl_coroutine
+#define ICUBABY_CPP_IMPL_COROUTINE_DEFINED (1)
+#else
+#define ICUBABY_CPP_IMPL_COROUTINE_DEFINED (0)
+#endif
+
+#ifdef __cpp_lib_coroutine
+#define ICUBABY_CPP_LIB_COROUTINE_DEFINED (1)
+#else
+#define ICUBABY_CPP_LIB_COROUTINE_DEFINED (0)
+#endif
+
+/// \brief Tests for the availability of compiler and library support for C++ 20
+///   coroutines.
+#define ICUBABY_HAVE_COROUTINES                                                                       \
+  (ICUBABY_CPP_IMPL_COROUTINE_DEFINED && __cpp_impl_coroutine >= 201902L && ICUBABY_CPP_LIB_COROUTINE_DEFINED && \
+   __cpp_lib_coroutine >= 201902L)
+#if ICUBABY_HAVE_COROUTINES
+#include <coroutine>
+#include <span>
+#endif
+
+#ifdef __cpp_lib_generator
+#define ICUBABY_CPP_LIB_GENERATOR_DEFINED (1)
+#else
+#define ICUBABY_CPP_LIB_GENERATOR_DEFINED (0)
+#endif
+
+/// \brief Tests for the availability of the C++ 23 std::generator<> class.
+#define ICUBABY_HAVE_STD_GENERATOR (ICUBABY_CPP_LIB_GENERATOR_DEFINED && __cpp_lib_generator >= 202207L)
+#if ICUBABY_HAVE_STD_GENERATOR
+#include <generator>
+#endif
+
 /// \brief Defined as true if compiler and library support for concepts are available.
 #ifdef __cpp_concepts
 #define ICUBABY_CPP_CONCEPTS_DEFINED (1)
@@ -127,6 +167,58 @@
 #define ICUBABY_REQUIRES(x)
 #endif  // ICUBABY_HAVE_CONCEPTS
 
+#ifdef __cpp_nontype_template_args
+#define ICUBABY_CPP_NONTYPE_TEMPLATE_ARGS_DEFINED (1)
+#else
+#define ICUBABY_CPP_NONTYPE_TEMPLATE_ARGS_DEFINED (0)
+#endif
+
+/// \brief Tests for the availability of class types as non-type template
+///   parameters.
+#define ICUBABY_HAVE_CLASS_NTTP (ICUBABY_CPP_NONTYPE_TEMPLATE_ARGS_DEFINED && __cpp_nontype_template_args >= 201911L)
+
+#ifdef __cpp_lib_bitops
+#define ICUBABY_CPP_LIB_BITOPS_DEFINED (1)
+#else
+#define ICUBABY_CPP_LIB_BITOPS_DEFINED (0)
+#endif
+
+/// \brief Tests for the availability of the C++ 20 bit manipulation functions
+///   such as std::countl_zero().
+#define ICUBABY_HAVE_BITOPS (ICUBABY_CPP_LIB_BITOPS_DEFINED && __cpp_lib_bitops >= 201907L)
+#if ICUBABY_HAVE_BITOPS
+#include <bit>
+#endif
+
+#ifdef __cpp_lib_is_constant_evaluated
+#define ICUBABY_CPP_LIB_IS_CONSTANT_EVALUATED_DEFINED (1)
+#else
+#define ICUBABY_CPP_LIB_IS_CONSTANT_EVALUATED_DEFINED (0)
+#endif
+
+/// \brief Tests whether the BMI2 parallel bit deposit instruction may be used.
+///   Since the intrinsic cannot be evaluated at compile time, its use also
+///   requires std::is_constant_evaluated().
+#if defined(__BMI2__) && ICUBABY_CPP_LIB_IS_CONSTANT_EVALUATED_DEFINED
+#define ICUBABY_HAVE_PDEP (__cpp_lib_is_constant_evaluated >= 201811L)
+#else
+#define ICUBABY_HAVE_PDEP (0)
+#endif
+#if ICUBABY_HAVE_PDEP
+#include <immintrin.h>
+#endif
+
+#ifdef __cpp_lib_string_resize_and_overwrite
+#define ICUBABY_CPP_LIB_STRING_RESIZE_AND_OVERWRITE_DEFINED (1)
+#else
+#define ICUBABY_CPP_LIB_STRING_RESIZE_AND_OVERWRITE_DEFINED (0)
+#endif
+
+/// \brief Tests for the availability of the C++ 23
+///   std::basic_string<>::resize_and_overwrite() member function.
+#define ICUBABY_HAVE_RESIZE_AND_OVERWRITE \
+  (ICUBABY_CPP_LIB_STRING_RESIZE_AND_OVERWRITE_DEFINED && __cpp_lib_string_resize_and_overwrite >= 202110L)
+
 /// \brief Defined as `[[no_unique_address]]` if the attribute is supported and
 ///   as nothing otherwise.
 /// \hideinitializer
@@ -214,6 +306,10 @@ using char8 = char8_t;
 using char8 = char;
 #endif
 
+/// The type of an ISO-8859-1 (Latin-1) code unit. Every code unit is a code
+/// point in the range U+0000..U+00FF.
+enum class latin1 : std::uint8_t {};
+
 /// A UTF-8 string.
 using u8string = std::basic_string<char8>;
 /// A UTF-8 string_view.
@@ -225,6 +321,9 @@ inline constexpr auto replacement_char = char32_t{0xFFFD};
 inline constexpr auto zero_width_no_break_space = char32_t{0xFEFF};
 /// A constant for U+FEFF ZERO WIDTH NO-BREAK SPACE (BYTE ORDER MARK)
 inline constexpr auto bom = zero_width_no_break_space;
+/// The Latin-1 code unit (U+001A SUBSTITUTE) written in place of a code point
+/// that cannot be represented in Latin-1.
+inline constexpr auto latin1_substitute = latin1{0x1A};
 
 /// \brief The number of bits required to represent a code point.
 ///
@@ -251,13 +350,14 @@ template <typename Encoding> struct longest_sequence {};
 template <> struct longest_sequence<char8> : std::integral_constant<std::size_t, 4> {};
 template <> struct longest_sequence<char16_t> : std::integral_constant<std::size_t, 2> {};
 template <> struct longest_sequence<char32_t> : std::integral_constant<std::size_t, 1> {};
+template <> struct longest_sequence<latin1> : std::integral_constant<std::size_t, 1> {};
 
 /// A helper variable template to simplify use of longest_sequence<>.
 template <typename Encoding> inline constexpr std::size_t longest_sequence_v = longest_sequence<Encoding>::value;
 
-/// A list of the character types used for UTF-8 UTF-16, and UTF-32 encoded
-/// text.
-using character_types = details::make_t<char8, char16_t, char32_t>;
+/// A list of the character types used for UTF-8 UTF-16, UTF-32, and Latin-1
+/// encoded text.
+using character_types = details::make_t<char8, char16_t, char32_t, latin1>;
 
 template <typename T> struct is_unicode_char_type : std::bool_constant<details::contains_v<character_types, T>> {};
 template <typename T> inline constexpr bool is_unicode_char_type_v = is_unicode_char_type<T>::value;
@@ -318,6 +418,14 @@ constexpr bool is_code_point_start (char16_t c) noexcept {
 constexpr bool is_code_point_start (char32_t c) noexcept {
   return !is_surrogate (c) && c <= max_code_point;
 }
+/// \brief Returns true: every Latin-1 code unit is a complete code point.
+///
+/// \param c  The Latin-1 code unit to be tested.
+/// \returns  true.
+constexpr bool is_code_point_start (latin1 c) noexcept {
+  (void)c;
+  return true;
+}
 
 #if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
 
@@ -452,19 +560,19 @@ public:
   using pointer = void;
   using reference = void;
 
-  iterator (Transcoder* transcoder, OutputIterator it) : transcoder_{transcoder}, it_{it} {}
-  iterator (iterator const& rhs) = default;
-  iterator (iterator&& rhs) noexcept = default;
+  constexpr iterator (Transcoder* transcoder, OutputIterator it) : transcoder_{transcoder}, it_{it} {}
+  constexpr iterator (iterator const& rhs) = default;
+  constexpr iterator (iterator&& rhs) noexcept = default;
 
   ~iterator () noexcept = default;
 
-  iterator& operator= (typename Transcoder::input_type const& value) {
+  constexpr iterator& operator= (typename Transcoder::input_type const& value) {
     it_ = (*transcoder_) (value, it_);
     return *this;
   }
 
-  iterator& operator= (iterator const& rhs) = default;
-  iterator& operator= (iterator&& rhs) noexcept = default;
+  constexpr iterator& operator= (iterator const& rhs) = default;
+  constexpr iterator& operator= (iterator&& rhs) noexcept = default;
 
   constexpr iterator& operator* () noexcept { return *this; }
   constexpr iterator& operator++ () noexcept { return *this; }
@@ -500,7 +608,7 @@ public:
   /// \returns  Iterator one past the last element assigned.
   template <typename OutputIterator>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
-  OutputIterator operator() (input_type c, OutputIterator dest) noexcept {
+  constexpr OutputIterator operator() (input_type c, OutputIterator dest) noexcept {
     if (c < 0x80) {
       *(dest++) = static_cast<output_type> (c);
       return dest;
@@ -541,6 +649,47 @@ public:
     return {t, t->end_cp (dest.base ())};
   }
 
+  /// Encodes a code point without branching on its value. The result is
+  /// identical to that of operator(), but the bytes are assembled in a 32-bit
+  /// word and all four are stored unconditionally before \p dest is advanced by
+  /// the length of the encoded sequence. This avoids the mispredictions which
+  /// operator() suffers when the input freely mixes code points of differing
+  /// lengths.
+  ///
+  /// \param c  The code point to be encoded.
+  /// \param dest  A pointer to an array with room for at least four code units,
+  ///   even though as few as one of them may form part of the output.
+  /// \returns  Pointer one past the last element of the encoded sequence.
+  constexpr output_type* write_padded (input_type c, output_type* dest) noexcept {
+    auto const bad = static_cast<std::uint_least32_t> (is_surrogate_value (c) | (c > max_code_point));
+    well_formed_ = static_cast<bool> (static_cast<unsigned> (well_formed_) & (bad ^ 1U));
+    auto const select = 0U - bad;
+    auto const code_point = (static_cast<std::uint_least32_t> (c) & ~select) | (replacement_char & select);
+
+    auto const length = transcoder::encoded_length (code_point);
+    std::uint_least32_t word = 0;
+#if ICUBABY_HAVE_PDEP
+    if (!std::is_constant_evaluated ()) {
+      word = _pdep_u32 (code_point, deposit_mask_[length]);
+    } else
+#endif
+    {
+      // Spread the code point's 6-bit groups across the bytes of the word: this
+      // matches the result of a bit deposit into deposit_mask_ for every length
+      // other than one. ASCII characters are copied whole.
+      auto const spread = (code_point & 0x3FU) | ((code_point << 2U) & 0x3F00U) |
+                          ((code_point << 4U) & 0x3F0000U) | ((code_point << 6U) & 0x3F000000U);
+      word = (spread & deposit_mask_[length] & spread_mask) | (code_point & deposit_mask_[length] & ~spread_mask);
+    }
+    // Move the first byte of the sequence to the top of the word.
+    word = (word | marker_[length]) << (8U * (4U - length));
+    dest[0] = static_cast<output_type> (word >> 24U);
+    dest[1] = static_cast<output_type> ((word >> 16U) & 0xFFU);
+    dest[2] = static_cast<output_type> ((word >> 8U) & 0xFFU);
+    dest[3] = static_cast<output_type> (word & 0xFFU);
+    return dest + length;
+  }
+
   /// \returns True if the input represented well formed UTF-32.
   [[nodiscard]] constexpr bool well_formed () const noexcept { return well_formed_; }
   [[nodiscard]] static constexpr bool partial () noexcept { return false; }
@@ -548,18 +697,46 @@ public:
 private:
   bool well_formed_ = true;
 
-  template <typename OutputIterator> static OutputIterator write2 (input_type c, OutputIterator dest) {
+  /// The bits of a code point which are carried by each byte of its encoding
+  /// indexed by the length of the encoded sequence. The first byte of the
+  /// sequence occupies the most significant byte of the value.
+  static constexpr std::array<std::uint_least32_t, 5> deposit_mask_{{0, 0x7F, 0x1F3F, 0x0F3F3F, 0x073F3F3F}};
+  /// The bits of deposit_mask_ which are laid out in 6-bit groups.
+  static constexpr std::uint_least32_t spread_mask = 0xFFFFFF00;
+  /// The fixed bits of each UTF-8 sequence indexed by its length.
+  static constexpr std::array<std::uint_least32_t, 5> marker_{{0, 0, 0xC080, 0xE08080, 0xF0808080}};
+
+  /// \returns  True if \p c is a surrogate code point, computed without branches.
+  static constexpr bool is_surrogate_value (input_type c) noexcept {
+    return static_cast<std::uint_least32_t> (c) - first_high_surrogate < 0x800U;
+  }
+
+  /// \returns  The number of bytes in the UTF-8 encoding of \p code_point
+  ///   which must not exceed max_code_point.
+  static constexpr unsigned encoded_length (std::uint_least32_t code_point) noexcept {
+#if ICUBABY_HAVE_BITOPS
+    // Indexed by the number of significant bits in the code point.
+    constexpr std::array<std::uint_least8_t, 22> lengths{
+        {1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4}};
+    return lengths[32U - static_cast<unsigned> (std::countl_zero (code_point))];
+#else
+    return 1U + static_cast<unsigned> (code_point >= 0x80U) + static_cast<unsigned> (code_point >= 0x800U) +
+           static_cast<unsigned> (code_point >= 0x10000U);
+#endif
+  }
+
+  template <typename OutputIterator> static constexpr OutputIterator write2 (input_type c, OutputIterator dest) {
     *(dest++) = static_cast<output_type> ((c >> 6U) | 0xc0U);
     *(dest++) = static_cast<output_type> ((c & 0x3fU) | 0x80U);
     return dest;
   }
-  template <typename OutputIterator> static OutputIterator write3 (input_type c, OutputIterator dest) {
+  template <typename OutputIterator> static constexpr OutputIterator write3 (input_type c, OutputIterator dest) {
     *(dest++) = static_cast<output_type> ((c >> 12U) | 0xe0U);
     *(dest++) = static_cast<output_type> (((c >> 6U) & 0x3fU) | 0x80U);
     *(dest++) = static_cast<output_type> ((c & 0x3fU) | 0x80U);
     return dest;
   }
-  template <typename OutputIterator> static OutputIterator write4 (input_type c, OutputIterator dest) {
+  template <typename OutputIterator> static constexpr OutputIterator write4 (input_type c, OutputIterator dest) {
     *(dest++) = static_cast<output_type> ((c >> 18U) | 0xf0U);
     *(dest++) = static_cast<output_type> (((c >> 12U) & 0x3fU) | 0x80U);
     *(dest++) = static_cast<output_type> (((c >> 6U) & 0x3fU) | 0x80U);
@@ -567,21 +744,124 @@ private:
     return dest;
   }
 
-  template <typename OutputIterator> OutputIterator not_well_formed (OutputIterator dest) {
+  template <typename OutputIterator> constexpr OutputIterator not_well_formed (OutputIterator dest) {
     well_formed_ = false;
     static_assert (!is_surrogate (replacement_char));
     return (*this) (replacement_char, dest);
   }
 };
 
-/// Takes a sequence of UTF-8 code units and converts them to UTF-32.
-template <> class transcoder<char8, char32_t> {
+namespace details {
+
+/// The tables of Bjoern Hoehrmann's UTF-8 decoding DFA.
+inline constexpr std::array<std::uint8_t, 364> utf8d = {{
+  // clang-format off
+  // The first part of the table maps bytes to character classes that
+  // to reduce the size of the transition table and create bitmasks.
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+   1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+   8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+  10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
+
+  // The second part is a transition table that maps a combination
+  // of a state of the automaton and a character class to a state.
+   0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
+  12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
+  12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
+  12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
+  12,36,12,12,12,12,12,12,12,12,12,12,
+  // clang-format on
+}};
+
+/// The number of states in the UTF-8 decoding DFA.
+inline constexpr auto utf8_states = 9U;
+/// The number of bits used to represent a state in a row of utf8_shift_rows.
+inline constexpr auto utf8_shift_bits = 6U;
+
+/// Builds the table used by shift_dfa. The row for a byte holds, for each
+/// state s of the DFA, the state that follows s on receipt of that byte. The
+/// states are represented as the bit offset of their field within a row. The
+/// top bits hold the mask to be applied to a byte if it begins a sequence.
+constexpr std::array<std::uint64_t, 256> make_utf8_shift_rows () noexcept {
+  std::array<std::uint64_t, 256> rows{};
+  for (auto byte = 0U; byte < rows.size (); ++byte) {
+    auto const type = utf8d[byte];
+    auto row = static_cast<std::uint64_t> ((0xFFU >> type) & 0xFFU) << 56U;
+    for (auto state = 0U; state < utf8_states; ++state) {
+      // The Hoehrmann table's states are multiples of 12.
+      auto const next = utf8d[256U + state * 12U + type] / 12U;
+      row |= static_cast<std::uint64_t> (next * utf8_shift_bits) << (state * utf8_shift_bits);
+    }
+    rows[byte] = row;
+  }
+  return rows;
+}
+inline constexpr std::array<std::uint64_t, 256> utf8_shift_rows = make_utf8_shift_rows ();
+static_assert (utf8_states * utf8_shift_bits <= 56U);
+
+}  // end namespace details
+
+/// A UTF-8 decoding engine which uses Bjoern Hoehrmann's DFA. Each byte is
+/// first mapped to a character class and the class and current state are then
+/// used to find the next state. This uses small (364 byte) tables, but the
+/// transition is a table load which depends on the previous state.
+struct table_dfa {
+  static constexpr std::uint_least8_t accept = 0;
+  static constexpr std::uint_least8_t reject = 12;
+
+  /// \returns  The bits of \p byte which contribute to the code point if it begins a sequence.
+  static constexpr std::uint_least32_t lead_bits (std::uint8_t byte) noexcept {
+    return (0xFFU >> details::utf8d[byte]) & byte;
+  }
+  /// \returns  The state which follows \p state on receipt of \p byte.
+  static constexpr std::uint_least8_t next (std::uint_least8_t state, std::uint8_t byte) noexcept {
+    auto const idx = 256U + state + details::utf8d[byte];
+    assert (idx < details::utf8d.size ());
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    return details::utf8d[idx];
+  }
+};
+
+/// A UTF-8 decoding engine which uses a shift-based DFA. A single load finds
+/// a 64-bit row holding the next state for every current state; the transition
+/// itself is a shift. The only operations which depend on the previous state
+/// are therefore a shift and a mask, shortening the dependency chain from one
+/// byte to the next. The table is 2KiB and is generated at compile time from
+/// that used by table_dfa.
+struct shift_dfa {
+  static constexpr std::uint_least8_t accept = 0;
+  static constexpr std::uint_least8_t reject = table_dfa::reject / 12U * details::utf8_shift_bits;
+
+  /// \returns  The bits of \p byte which contribute to the code point if it begins a sequence.
+  static constexpr std::uint_least32_t lead_bits (std::uint8_t byte) noexcept {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    return static_cast<std::uint_least32_t> (details::utf8_shift_rows[byte] >> 56U) & byte;
+  }
+  /// \returns  The state which follows \p state on receipt of \p byte.
+  static constexpr std::uint_least8_t next (std::uint_least8_t state, std::uint8_t byte) noexcept {
+    constexpr auto mask = (std::uint64_t{1} << details::utf8_shift_bits) - 1U;
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+    return static_cast<std::uint_least8_t> ((details::utf8_shift_rows[byte] >> state) & mask);
+  }
+};
+
+/// Takes a sequence of UTF-8 code units and converts them to UTF-32 using the
+/// decoding engine given by \p Engine (table_dfa or shift_dfa). The transcoder
+/// for UTF-8 to UTF-32 is a utf8_decoder using shift_dfa: when bytes are
+/// decoded one after another the transition's dependency chain dominates and
+/// shift_dfa is the faster at every proportion of non-ASCII input that
+/// tests/bench8 measures.
+template <typename Engine> class utf8_decoder {
 public:
   using input_type = char8;
   using output_type = char32_t;
 
-  constexpr transcoder () noexcept : transcoder (true) {}
-  explicit constexpr transcoder (bool well_formed) noexcept
+  constexpr utf8_decoder () noexcept : utf8_decoder (true) {}
+  explicit constexpr utf8_decoder (bool well_formed) noexcept
       : code_point_{0}, well_formed_{static_cast<uint_least32_t> (well_formed)}, pad_{0}, state_{accept} {
     pad_ = 0;  // Suppress warning about pad_ being unused.
   }
@@ -593,29 +873,21 @@ public:
   /// \returns  Iterator one past the last element assigned.
   template <typename OutputIterator>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
-  OutputIterator operator() (input_type code_unit, OutputIterator dest) {
+  constexpr OutputIterator operator() (input_type code_unit, OutputIterator dest) {
     // Prior to C++20, char8 might be signed.
     static_assert (sizeof (input_type) == sizeof (std::uint8_t));
     auto const ucu = static_cast<std::uint8_t> (code_unit);
-    static_assert (std::is_unsigned_v<decltype (ucu)> && std::numeric_limits<decltype (ucu)>::max () <= utf8d_.size ());
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-    auto const type = utf8d_[ucu];
     code_point_ = (state_ != accept)
                       ? static_cast<std::uint_least32_t> (static_cast<std::byte> (code_unit) & std::byte{0x3FU}) |
                             static_cast<uint_least32_t> (code_point_ << 6U)
-                      : (0xFFU >> type) & ucu;
-    auto const idx = 256U + state_ + type;
-    assert (idx < utf8d_.size ());
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-    state_ = utf8d_[idx];
-    switch (state_) {
-    case accept: *(dest++) = code_point_; break;
-    case reject:
+                      : Engine::lead_bits (ucu);
+    state_ = Engine::next (static_cast<std::uint_least8_t> (state_), ucu);
+    if (state_ == accept) {
+      *(dest++) = code_point_;
+    } else if (state_ == reject) {
       well_formed_ = false;
       state_ = accept;
       *(dest++) = replacement_char;
-      break;
-    default: break;
     }
     return dest;
   }
@@ -637,9 +909,10 @@ public:
     return dest;
   }
 
-  template <typename OutputIterator>
+  template <typename Transcoder, typename OutputIterator>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
-  constexpr iterator<transcoder, OutputIterator> end_cp (iterator<transcoder, OutputIterator> dest) {
+  constexpr iterator<Transcoder, OutputIterator> end_cp (iterator<Transcoder, OutputIterator> dest) {
+    static_assert (std::is_base_of_v<utf8_decoder, Transcoder>);
     auto t = dest.transcoder ();
     assert (t == this);
     return {t, t->end_cp (dest.base ())};
@@ -650,35 +923,21 @@ public:
   [[nodiscard]] constexpr bool partial () const noexcept { return state_ != accept; }
 
 private:
-  static inline std::array<uint8_t, 364> const utf8d_ = {{
-    // clang-format off
-    // The first part of the table maps bytes to character classes that
-    // to reduce the size of the transition table and create bitmasks.
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
-     7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,  7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
-     8,8,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
-    10,3,3,3,3,3,3,3,3,3,3,3,3,4,3,3, 11,6,6,6,5,8,8,8,8,8,8,8,8,8,8,8,
-
-    // The second part is a transition table that maps a combination
-    // of a state of the automaton and a character class to a state.
-     0,12,24,36,60,96,84,12,12,12,48,72, 12,12,12,12,12,12,12,12,12,12,12,12,
-    12, 0,12,12,12,12,12, 0,12, 0,12,12, 12,24,12,12,12,12,12,24,12,24,12,12,
-    12,12,12,12,12,12,12,24,12,12,12,12, 12,24,12,12,12,12,12,12,12,24,12,12,
-    12,12,12,12,12,12,12,36,12,36,12,12, 12,36,12,12,12,12,12,36,12,36,12,12,
-    12,36,12,12,12,12,12,12,12,12,12,12,
-    // clang-format on
-  }};
+  static constexpr auto accept = Engine::accept;
+  static constexpr auto reject = Engine::reject;
+
   uint_least32_t code_point_ : code_point_bits;
   uint_least32_t well_formed_ : 1;
   uint_least32_t pad_ : 2;
-  enum : std::uint8_t { accept, reject = 12 };
   uint_least32_t state_ : 8;
 };
 
+/// Takes a sequence of UTF-8 code units and converts them to UTF-32.
+template <> class transcoder<char8, char32_t> : public utf8_decoder<shift_dfa> {
+public:
+  using utf8_decoder::utf8_decoder;
+};
+
 /// Takes a sequence of UTF-32 code units and converts them to UTF-16.
 template <> class transcoder<char32_t, char16_t> {
 public:
@@ -692,7 +951,7 @@ public:
   /// \returns  The output iterator.
   template <typename OutputIterator>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
-  OutputIterator operator() (input_type code_point, OutputIterator dest) {
+  constexpr OutputIterator operator() (input_type code_point, OutputIterator dest) {
     if (code_point <= 0xFFFF) {
       *(dest++) = static_cast<output_type> (code_point);
     } else if (is_surrogate (code_point) || code_point > max_code_point) {
@@ -746,7 +1005,7 @@ public:
 
   template <typename OutputIterator>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
-  OutputIterator operator() (input_type c, OutputIterator dest) {
+  constexpr OutputIterator operator() (input_type c, OutputIterator dest) {
     if (!has_high_) {
       if (is_high_surrogate (c)) {
         // A high surrogate code unit indicates that this is the first of a
@@ -798,7 +1057,7 @@ public:
   /// \returns  The output iterator.
   template <typename OutputIterator>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
-  OutputIterator end_cp (OutputIterator dest) {
+  constexpr OutputIterator end_cp (OutputIterator dest) {
     if (has_high_) {
       *(dest++) = replacement_char;
       high_ = 0;
@@ -841,7 +1100,7 @@ public:
 
   template <typename OutputIterator>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
-  OutputIterator operator() (input_type c, OutputIterator dest) {
+  constexpr OutputIterator operator() (input_type c, OutputIterator dest) {
     // The (intermediate) output from the conversion to UTF-32. It's possible
     // for the transcoder to produce more than a single output code unit if the
     // input is malformed.
@@ -860,7 +1119,7 @@ public:
   /// \returns  Iterator one past the last element assigned.
   template <typename OutputIterator>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
-  OutputIterator end_cp (OutputIterator dest) {
+  constexpr OutputIterator end_cp (OutputIterator dest) {
     std::array<char32_t, 2> intermediate{};
     // NOLINTNEXTLINE(llvm-qualified-auto,readability-qualified-auto)
     auto begin = std::begin (intermediate);
@@ -884,9 +1143,7 @@ public:
   }
 
   /// Returns true if the input passed to operator() was valid.
-  [[nodiscard]] constexpr bool well_formed () const noexcept {
-    return to_inter_.well_formed () && to_out_.well_formed ();
-  }
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return to_inter_.well_formed (); }
 
   /// Returns true if a partial code-unit has been passed to operator() and
   /// false otherwise.
@@ -894,11 +1151,17 @@ public:
 
 private:
   transcoder<input_type, char32_t> to_inter_;
-  transcoder<char32_t, output_type> to_out_;
 
   template <typename InputIterator, typename OutputIterator>
-  OutputIterator copy (InputIterator first, InputIterator last, OutputIterator dest) {
-    std::for_each (first, last, [this, &dest] (char32_t c) { dest = to_out_ (c, dest); });
+  static constexpr OutputIterator copy (InputIterator first, InputIterator last, OutputIterator dest) {
+    // The intermediate code points are always valid (ill-formed input having been replaced by
+    // U+FFFD) and encoding a valid code point requires no state, so a transcoder to the output
+    // encoding need not be stored.
+    transcoder<char32_t, output_type> to_out;
+    for (; first != last; ++first) {
+      dest = to_out (*first, dest);
+    }
+    assert (to_out.well_formed ());
     return dest;
   }
 };
@@ -921,7 +1184,7 @@ public:
 
   template <typename OutputIt>
   ICUBABY_REQUIRES ((std::output_iterator<OutputIt, output_type>))
-  OutputIt operator() (input_type c, OutputIt dest) {
+  constexpr OutputIt operator() (input_type c, OutputIt dest) {
     // From D90 in Chapter 3 of Unicode 15.0.0
     // <https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf>:
     //
@@ -986,194 +1249,2557 @@ using t32_16 = transcoder<char32_t, char16_t>;
 /// represents no change and is included for completeness.
 using t32_32 = transcoder<char32_t, char32_t>;
 
-#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
-
-namespace ranges {
+namespace details {
 
-template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View>
-  requires std::ranges::view<View>
-class transcode_view : public std::ranges::view_interface<transcode_view<FromEncoding, ToEncoding, View>> {
+/// Converts Latin-1 code units to UTF-8, UTF-16, UTF-32, or Latin-1. Since
+/// every Latin-1 code unit is a complete code point in the range
+/// U+0000..U+00FF, the input is always well formed and no state is needed.
+template <typename To> class latin1_decoder {
 public:
-  class iterator;
-  class sentinel;
+  using input_type = latin1;
+  using output_type = To;
 
-  transcode_view () requires std::default_initializable<View> = default;
-  constexpr explicit transcode_view (View base) : base_ (std::move (base)) {}
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr OutputIterator operator() (input_type c, OutputIterator dest) const {
+    auto const value = static_cast<std::uint_least8_t> (c);
+    if constexpr (std::is_same_v<To, char8>) {
+      if (value >= 0x80U) {
+        *(dest++) = static_cast<output_type> ((value >> 6U) | 0xC0U);
+        *(dest++) = static_cast<output_type> ((value & 0x3FU) | 0x80U);
+        return dest;
+      }
+    }
+    *(dest++) = static_cast<output_type> (value);
+    return dest;
+  }
 
-  constexpr View base () const& requires std::copy_constructible<View> { return base_; }
-  constexpr View base () && { return std::move (base_); }
+  /// Call once the entire input sequence has been fed to operator(). Latin-1
+  /// input cannot end with a partial code point so nothing is written.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which value of type
+  ///   output_type can be written.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr OutputIterator end_cp (OutputIterator dest) const {
+    return dest;
+  }
 
-  constexpr auto begin () const { return iterator{*this, std::ranges::begin (base_)}; }
-  constexpr auto end () const {
-    if constexpr (std::ranges::common_range<View>) {
-      return iterator{*this, std::ranges::end (base_)};
-    } else {
-      return sentinel{*this};
-    }
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr iterator<transcoder<latin1, To>, OutputIterator> end_cp (
+      iterator<transcoder<latin1, To>, OutputIterator> dest) {
+    auto t = dest.transcoder ();
+    assert (t == this);
+    return {t, t->end_cp (dest.base ())};
   }
 
-private:
-  [[no_unique_address]] View base_ = View ();
+  [[nodiscard]] static constexpr bool well_formed () noexcept { return true; }
+  [[nodiscard]] static constexpr bool partial () noexcept { return false; }
 };
 
-template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View>
-  requires std::ranges::view<View>
-class transcode_view<FromEncoding, ToEncoding, View>::iterator {
+/// Converts UTF-8, UTF-16, or UTF-32 code units to Latin-1. The input is
+/// decoded to UTF-32 and code points beyond U+00FF are replaced by
+/// latin1_substitute.
+template <typename From> class latin1_encoder {
 public:
-  using iterator_category = std::forward_iterator_tag;
-  using iterator_concept = std::forward_iterator_tag;
-
-  using value_type = ToEncoding;
-  using difference_type = std::ranges::range_difference_t<View>;
+  using input_type = From;
+  using output_type = latin1;
 
-  iterator () requires std::default_initializable<std::ranges::iterator_t<View>> = default;
-  constexpr iterator (transcode_view const& parent, std::ranges::iterator_t<View> current)
-      : current_{current}, parent_{&parent}, state_{current} {
-    assert (state_.empty ());
-    // Prime the input state so that a dereference of the iterator will yield the first of the
-    // output code-units.
-    current_ = state_.fill (parent_->base_);
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr OutputIterator operator() (input_type c, OutputIterator dest) {
+    std::array<char32_t, 2> intermediate{};
+    // NOLINTNEXTLINE(llvm-qualified-auto,readability-qualified-auto)
+    auto begin = std::begin (intermediate);
+    return this->copy (begin, to_inter_ (c, begin), dest);
   }
 
-  /// \returns True if the input encoding was well-formed.
-  [[nodiscard]] constexpr bool well_formed () const noexcept { return state_.transcoder_.well_formed (); }
-
-  constexpr std::ranges::iterator_t<View> const& base () const& noexcept { return current_; }
-  constexpr std::ranges::iterator_t<View> base () && { return std::move (current_); }
-
-  constexpr value_type const& operator* () const { return state_.front (); }
-  constexpr std::ranges::iterator_t<View> operator->() const { return state_.front (); }
-
-  constexpr iterator& operator++ () {
-    state_.advance ();
-    if (state_.empty ()) {
-      // We've exhausted the stashed output code units. Refill the buffer and reset.
-      current_ = state_.fill (parent_->base_);
-    }
-    return *this;
-  }
-  constexpr void operator++ (int) { ++*this; }
-  constexpr iterator operator++ (int) requires std::ranges::forward_range<View> {
-    auto result = *this;
-    ++*this;
-    return result;
+  /// Call once the entire input sequence has been fed to operator(). This
+  /// function ensures that the sequence did not end with a partial code point.
+  ///
+  /// \tparam OutputIterator  An output iterator type to which value of type
+  ///   output_type can be written.
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr OutputIterator end_cp (OutputIterator dest) {
+    std::array<char32_t, 2> intermediate{};
+    // NOLINTNEXTLINE(llvm-qualified-auto,readability-qualified-auto)
+    auto begin = std::begin (intermediate);
+    return this->copy (begin, to_inter_.end_cp (begin), dest);
   }
 
-  friend constexpr bool operator== (iterator const& x, iterator const& y)
-    requires std::equality_comparable<std::ranges::iterator_t<View>>
-  {
-    return x.current_ == y.current_;
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr iterator<transcoder<From, latin1>, OutputIterator> end_cp (
+      iterator<transcoder<From, latin1>, OutputIterator> dest) {
+    auto t = dest.transcoder ();
+    assert (t == this);
+    return {t, t->end_cp (dest.base ())};
   }
 
-  friend constexpr std::ranges::range_rvalue_reference_t<View> iter_move (iterator const& it) noexcept (
-      noexcept (std::ranges::iter_move (it.current_))) {
-    return std::ranges::iter_move (it.current_);
-  }
+  /// Returns true if the input passed to operator() was valid and every code
+  /// point could be represented in Latin-1.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return to_inter_.well_formed () && !unmappable_; }
 
-  friend constexpr void iter_swap (iterator const& x,
-                                   iterator const& y) noexcept (noexcept (std::ranges::iter_swap (x.current_,
-                                                                                                  y.current_)))
-    requires std::indirectly_swappable<std::ranges::iterator_t<View>>
-  {
-    return std::ranges::iter_swap (x.current_, y.current_);
-  }
+  /// Returns true if a partial code-unit has been passed to operator() and
+  /// false otherwise.
+  [[nodiscard]] constexpr bool partial () const noexcept { return to_inter_.partial (); }
 
 private:
-  std::ranges::iterator_t<View> current_{};
-  transcode_view const* parent_ = nullptr;
+  transcoder<input_type, char32_t> to_inter_;
+  /// true if a code point beyond U+00FF has been seen.
+  bool unmappable_ = false;
 
-  class state {
-  public:
-    constexpr explicit state (std::ranges::iterator_t<View> const& it) : next_{it}, valid_{out_.end (), out_.end ()} {}
-    constexpr state () : state{std::ranges::iterator_t<View>{}} {}
+  template <typename InputIterator, typename OutputIterator>
+  constexpr OutputIterator copy (InputIterator first, InputIterator last, OutputIterator dest) {
+    for (; first != last; ++first) {
+      auto const c = *first;
+      if (c > 0xFFU) {
+        unmappable_ = true;
+        *(dest++) = latin1_substitute;
+      } else {
+        *(dest++) = static_cast<output_type> (c);
+      }
+    }
+    return dest;
+  }
+};
 
-    [[nodiscard]] constexpr bool empty () const noexcept { return valid_.empty (); }
-    [[nodiscard]] constexpr auto& front () const noexcept { return valid_.front (); }
-    constexpr void advance () noexcept { valid_.advance (1); }
+}  // end namespace details
 
-    /// Consumes enough code-units from the base iterator to form a single code-point. The resulting
-    /// code-units in the output encoding can be sequentially accessed using the front() and
-    /// advance() methods.
-    ///
-    /// \returns The updated base iterator.
-    constexpr std::ranges::iterator_t<View> fill (View const& base);
+/// Takes a sequence of Latin-1 code units and converts them to UTF-8.
+template <> class transcoder<latin1, char8> : public details::latin1_decoder<char8> {};
+/// Takes a sequence of Latin-1 code units and converts them to UTF-16.
+template <> class transcoder<latin1, char16_t> : public details::latin1_decoder<char16_t> {};
+/// Takes a sequence of Latin-1 code units and converts them to UTF-32.
+template <> class transcoder<latin1, char32_t> : public details::latin1_decoder<char32_t> {};
+/// Takes a sequence of Latin-1 code units and converts them to Latin-1.
+template <> class transcoder<latin1, latin1> : public details::latin1_decoder<latin1> {};
+/// Takes a sequence of UTF-8 code units and converts them to Latin-1.
+template <> class transcoder<char8, latin1> : public details::latin1_encoder<char8> {};
+/// Takes a sequence of UTF-16 code units and converts them to Latin-1.
+template <> class transcoder<char16_t, latin1> : public details::latin1_encoder<char16_t> {};
+/// Takes a sequence of UTF-32 code units and converts them to Latin-1.
+template <> class transcoder<char32_t, latin1> : public details::latin1_encoder<char32_t> {};
+
+/// A shorter name for the Latin-1 to UTF-8 transcoder.
+using tl1_8 = transcoder<latin1, char8>;
+/// A shorter name for the Latin-1 to UTF-16 transcoder.
+using tl1_16 = transcoder<latin1, char16_t>;
+/// A shorter name for the Latin-1 to UTF-32 transcoder.
+using tl1_32 = transcoder<latin1, char32_t>;
+/// A shorter name for the Latin-1 to Latin-1 transcoder. This represents no
+/// change and is included for completeness.
+using tl1_l1 = transcoder<latin1, latin1>;
+/// A shorter name for the UTF-8 to Latin-1 transcoder.
+using t8_l1 = transcoder<char8, latin1>;
+/// A shorter name for the UTF-16 to Latin-1 transcoder.
+using t16_l1 = transcoder<char16_t, latin1>;
+/// A shorter name for the UTF-32 to Latin-1 transcoder.
+using t32_l1 = transcoder<char32_t, latin1>;
+
+/// The byte-oriented encodings which may be identified by sniff() and decoded
+/// by byte_transcoder.
+enum class encoding : std::uint8_t { unknown, utf8, utf16be, utf16le, utf32be, utf32le };
+
+template <typename To> class byte_transcoder;
 
-  private:
-    using out_type = std::array<ToEncoding, longest_sequence_v<ToEncoding>>;
-    using iterator = typename out_type::iterator;
+namespace details {
 
-    std::ranges::iterator_t<View> next_;
-    transcoder<FromEncoding, ToEncoding> transcoder_;
-    /// The container into which the transcoder's output will be written.
-    out_type out_{};
-    /// The valid ragne of code units in the out_ container. Determines the code-units to be
-    /// produced when the view is dereferenced.
-    std::ranges::subrange<iterator> valid_;
-  };
-  mutable state state_{};
+/// Yields an unsigned integer type whose size is \p Size bytes.
+template <std::size_t Size> struct uint_of_size {};
+template <> struct uint_of_size<1> {
+  using type = std::uint8_t;
 };
+template <> struct uint_of_size<2> {
+  using type = std::uint16_t;
+};
+template <> struct uint_of_size<4> {
+  using type = std::uint32_t;
+};
+template <std::size_t Size> using uint_of_size_t = typename uint_of_size<Size>::type;
 
-template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View>
-  requires std::ranges::view<View>
-constexpr std::ranges::iterator_t<View> transcode_view<FromEncoding, ToEncoding, View>::iterator::state::fill (
-    View const& base) {
-  auto result = next_;
-  assert (this->empty () && "out_ was not empty when fill called");
-
-  auto it = out_.begin ();
+/// Converts a code unit (or byte) to its unsigned integer value.
+template <typename T> constexpr uint_of_size_t<sizeof (T)> unit_value (T c) noexcept {
+  return static_cast<uint_of_size_t<sizeof (T)>> (c);
+}
 
-  if (auto const input_end = std::ranges::end (base); next_ == input_end) {
-    // We've consumed the entire input so tell the transcoder and get any final output.
-    it = transcoder_.end_cp (it);
-  } else {
-    // Loop until we've produced a code-point's worth of code-units in the out
-    // container or we've run out of input.
-    while (it == out_.begin () && next_ != input_end) {
-      it = transcoder_ (*next_, it);
-      ++next_;
-    }
+/// The number of elements of type \p T that fit in a single 64-bit word.
+template <typename T> inline constexpr std::size_t units_per_word = sizeof (std::uint64_t) / sizeof (T);
+
+/// Returns a 64-bit word assembled from the units_per_word<T> elements starting
+/// at \p p. The first element occupies the least significant bits of the result
+/// regardless of the host's byte order. Compilers recognize this pattern and
+/// emit a single load.
+template <typename T> constexpr std::uint64_t load_word (T const* p) noexcept {
+  auto result = std::uint64_t{0};
+  for (auto ctr = std::size_t{0}; ctr < units_per_word<T>; ++ctr) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    result |= static_cast<std::uint64_t> (unit_value (p[ctr])) << (ctr * 8U * sizeof (T));
   }
-  assert (it >= out_.begin () && it <= out_.end ());
-  valid_ = std::ranges::subrange<iterator>{out_.begin (), it};
   return result;
 }
 
-template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View>
-  requires std::ranges::view<View>
-class transcode_view<FromEncoding, ToEncoding, View>::sentinel {
-public:
-  sentinel () = default;
-  constexpr explicit sentinel (transcode_view& parent) : end_{std::ranges::end (parent.base_)} {}
-  constexpr std::ranges::sentinel_t<View> base () const { return end_; }
-  friend constexpr bool operator== (iterator const& x, sentinel const& y) { return x.current_ == y.end_; }
+/// Returns a 64-bit word with \p v replicated into each lane of sizeof(T) bytes.
+template <typename T> constexpr std::uint64_t broadcast (std::uint64_t v) noexcept {
+  auto result = std::uint64_t{0};
+  for (auto ctr = std::size_t{0}; ctr < units_per_word<T>; ++ctr) {
+    result |= v << (ctr * 8U * sizeof (T));
+  }
+  return result;
+}
 
-private:
-  std::ranges::sentinel_t<View> end_{};
-};
+/// A mask which, when ANDed with a word produced by load_word<T>(), is
+/// non-zero if any of the lanes hold a value outside of the ASCII range.
+template <typename T> inline constexpr std::uint64_t non_ascii_mask = ~broadcast<T> (0x7F);
 
-namespace views::transcode {
+/// Returns a word whose lanes of sizeof(T) bytes have their top bit set where
+/// the corresponding lane of \p w is zero and are clear otherwise.
+template <typename T> constexpr std::uint64_t zero_lanes (std::uint64_t w) noexcept {
+  constexpr auto low_bits = broadcast<T> ((std::uint64_t{1} << (8U * sizeof (T) - 1U)) - 1U);
+  return ~(((w & low_bits) + low_bits) | w | low_bits);
+}
 
-template <unicode_char_type FromEncoding, unicode_char_type ToEncoding> class transcode_range_adaptor {
-public:
-  template <std::ranges::viewable_range Range> constexpr auto operator() (Range&& range) const {
-    return transcode_view<FromEncoding, ToEncoding, std::ranges::views::all_t<Range>>{std::forward<Range> (range)};
+/// Returns the number of set bits in \p w.
+constexpr unsigned count_bits (std::uint64_t w) noexcept {
+  auto result = 0U;
+  for (; w != 0U; w &= w - 1U) {
+    ++result;
   }
-};
-
-template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::viewable_range Range>
-constexpr auto operator| (Range&& r, transcode_range_adaptor<FromEncoding, ToEncoding> const& adaptor) {
-  return adaptor (std::forward<Range> (r));
+  return result;
 }
 
-}  // end namespace views::transcode
-
-template <unicode_char_type FromEncoding, unicode_char_type ToEncoding>
-inline constexpr auto transcode = views::transcode::transcode_range_adaptor<FromEncoding, ToEncoding>{};
+/// Returns a pointer to the first element of [first, last) which lies outside
+/// of the ASCII range or \p last if there is no such element. A word's worth of
+/// code units is examined at each step.
+template <typename T> constexpr T const* find_non_ascii (T const* first, T const* last) noexcept {
+  for (; static_cast<std::size_t> (last - first) >= units_per_word<T>; first += units_per_word<T>) {
+    if ((load_word (first) & non_ascii_mask<T>) != 0U) {
+      break;
+    }
+  }
+  return std::find_if (first, last, [] (T c) { return unit_value (c) > 0x7FU; });
+}
+
+/// An output iterator which discards the values written to it, but counts
+/// the number of assignments made.
+class counting_iterator {
+public:
+  using iterator_category = std::output_iterator_tag;
+  using value_type = void;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = void;
+
+  constexpr counting_iterator () noexcept = default;
+  explicit constexpr counting_iterator (std::size_t count) noexcept : count_{count} {}
+
+  template <typename T> constexpr counting_iterator& operator= (T const&) noexcept { return *this; }
+  constexpr counting_iterator& operator* () noexcept { return *this; }
+  constexpr counting_iterator& operator++ () noexcept {
+    ++count_;
+    return *this;
+  }
+  constexpr counting_iterator operator++ (int) noexcept {
+    auto const prev = *this;
+    ++count_;
+    return prev;
+  }
+
+  /// \returns The number of values written to the iterator.
+  [[nodiscard]] constexpr std::size_t count () const noexcept { return count_; }
+
+private:
+  std::size_t count_ = 0;
+};
+
+/// Returns true if ASCII code units passed to transcoder \p t will be output
+/// unchanged.
+template <typename Transcoder> constexpr bool passes_ascii (Transcoder const& t) noexcept {
+  return !t.partial ();
+}
+/// ASCII bytes are only output unchanged by a byte_transcoder decoding UTF-8.
+template <typename To> constexpr bool passes_ascii (byte_transcoder<To> const& t) noexcept {
+  return t.input_encoding () == encoding::utf8 && !t.partial ();
+}
+
+}  // end namespace details
+
+/// Passes the code units in the range [first, last) to transcoder \p t writing
+/// the results to \p dest. The behavior is identical to calling t(c, dest) for
+/// each of the input code units, but runs of ASCII code units are detected a
+/// word at a time and copied directly to the output when the input is a
+/// contiguous array.
+///
+/// Note that transcoder::end_cp() is not called: more input may be passed to
+/// \p t after this function returns.
+///
+/// \param t  The transcoder to which the input code units are passed.
+/// \param first  The start of the range of code units to be transcoded.
+/// \param last  The end of the range of code units to be transcoded.
+/// \param dest  An output iterator to which the output sequence is written.
+/// \returns  Iterator one past the last element assigned.
+template <typename Transcoder, typename InputIterator, typename OutputIterator>
+ICUBABY_REQUIRES ((is_transcoder<Transcoder> && std::output_iterator<OutputIterator, typename Transcoder::output_type>))
+OutputIterator transcode (Transcoder& t, InputIterator first, InputIterator last, OutputIterator dest) {
+  using input_type = typename Transcoder::input_type;
+  using output_type = typename Transcoder::output_type;
+  if constexpr (std::is_pointer_v<InputIterator> &&
+                sizeof (typename std::iterator_traits<InputIterator>::value_type) == sizeof (input_type)) {
+    while (first != last) {
+      if (details::unit_value (*first) < 0x80U && details::passes_ascii (t)) {
+        auto const ascii_end = first + (details::find_non_ascii (first, last) - first);
+        dest = std::transform (first, ascii_end, dest, [] (auto c) { return static_cast<output_type> (c); });
+        first = ascii_end;
+        if (first == last) {
+          break;
+        }
+      }
+      dest = t (static_cast<input_type> (*first), dest);
+      ++first;
+    }
+    return dest;
+  } else {
+    for (; first != last; ++first) {
+      dest = t (static_cast<input_type> (*first), dest);
+    }
+    return dest;
+  }
+}
+
+/// Encodes the UTF-32 code units in the range [first, last) as UTF-8 writing the
+/// results to the buffer [dest, dest_last). The result is the same as that of
+/// the generic transcode() function, but while at least four elements of the
+/// buffer remain, each code point is encoded by transcoder::write_padded()
+/// rather than by a branch for each sequence length.
+///
+/// Note that transcoder::end_cp() is not called: more input may be passed to
+/// \p t after this function returns.
+///
+/// \param t  The transcoder to which the input code units are passed.
+/// \param first  The start of the range of code units to be transcoded.
+/// \param last  The end of the range of code units to be transcoded.
+/// \param dest  The start of the output buffer.
+/// \param dest_last  The end of the output buffer which must be large enough
+///   to hold the entire output sequence.
+/// \returns  Pointer one past the last element assigned.
+inline char8* transcode (transcoder<char32_t, char8>& t, char32_t const* first, char32_t const* last, char8* dest,
+                         char8* dest_last) {
+  for (; first != last && dest_last - dest >= 4; ++first) {
+    dest = t.write_padded (*first, dest);
+  }
+  for (; first != last; ++first) {
+    dest = t (*first, dest);
+  }
+  assert (dest <= dest_last);
+  return dest;
+}
+
+namespace details {
+
+/// Expands the eight Latin-1 code units held in \p w (see load_word()) to
+/// UTF-8. The selection between one and two output code units is made with
+/// masks rather than branches, so both are always stored.
+///
+/// \param w  Eight Latin-1 code units.
+/// \param dest  A pointer to an array with room for at least 16 code units.
+/// \returns  Pointer one past the last element of the encoded sequence.
+constexpr char8* latin1_word_to_utf8 (std::uint64_t w, char8* dest) noexcept {
+  for (auto lane = 0U; lane < units_per_word<latin1>; ++lane, w >>= 8U) {
+    auto const value = static_cast<std::uint_least32_t> (w & 0xFFU);
+    auto const high = value >> 7U;
+    auto const select = 0U - high;
+    dest[0] = static_cast<char8> ((((value >> 6U) | 0xC0U) & select) | (value & ~select));
+    dest[1] = static_cast<char8> ((value & 0x3FU) | 0x80U);
+    dest += 1U + high;
+  }
+  return dest;
+}
+
+/// Converts the eight UTF-8 code units held in \p w (see load_word()) to
+/// Latin-1 if they fit: that is, if each is either ASCII or part of a complete
+/// two code unit sequence starting with 0xC2 or 0xC3 (U+0080..U+00FF). A lead
+/// in the final lane is left for the next word. The check is made a word at a
+/// time and the output is compacted without branches.
+///
+/// \param w  Eight UTF-8 code units.
+/// \param dest  A pointer to an array with room for at least eight code units.
+/// \returns  The number of input code units consumed (zero if the input does
+///   not fit) and a pointer one past the last element of the output.
+constexpr std::pair<std::size_t, latin1*> utf8_word_to_latin1 (std::uint64_t w, latin1* dest) noexcept {
+  constexpr auto top_bits = broadcast<char8> (0x80);
+  constexpr auto last_lane = std::uint64_t{0xFF} << 56U;
+  auto const non_ascii = w & top_bits;
+  // Lead bytes 0xC2 and 0xC3 and continuation bytes 0x80..0xBF.
+  auto const leads = zero_lanes<char8> ((w ^ broadcast<char8> (0xC2)) & broadcast<char8> (0xFE));
+  auto const continuations = w & ~(w << 1U) & top_bits;
+  // Each continuation must immediately follow a lead in the same word.
+  if ((leads | continuations) != non_ascii || continuations != (leads << 8U)) {
+    return {0, dest};
+  }
+  // A lead in the final lane is skipped in the same way as a continuation.
+  auto const skip = continuations | (leads & last_lane);
+  for (auto lane = 0U; lane < units_per_word<char8>; ++lane, w >>= 8U) {
+    auto const value = static_cast<std::uint_least32_t> (w & 0xFFU);
+    auto const select = 0U - static_cast<std::uint_least32_t> ((leads >> (8U * lane + 7U)) & 1U);
+    auto const combined = ((value & 0x03U) << 6U) | ((w >> 8U) & 0x3FU);
+    *dest = static_cast<latin1> ((combined & select) | (value & ~select));
+    dest += 1U - static_cast<std::uint_least32_t> ((skip >> (8U * lane + 7U)) & 1U);
+  }
+  return {units_per_word<char8> - static_cast<std::size_t> ((leads & last_lane) != 0U), dest};
+}
+
+}  // end namespace details
+
+/// Converts the Latin-1 code units in the range [first, last) to UTF-8 writing
+/// the results to the buffer [dest, dest_last). The result is the same as that
+/// of the generic transcode() function, but the input is processed a word at a
+/// time: runs of ASCII are copied directly and other words are expanded without
+/// branches while the buffer has room.
+///
+/// \param t  The transcoder to which the input code units are passed.
+/// \param first  The start of the range of code units to be transcoded.
+/// \param last  The end of the range of code units to be transcoded.
+/// \param dest  The start of the output buffer.
+/// \param dest_last  The end of the output buffer which must be large enough
+///   to hold the entire output sequence.
+/// \returns  Pointer one past the last element assigned.
+inline char8* transcode (transcoder<latin1, char8>& t, latin1 const* first, latin1 const* last, char8* dest,
+                         char8* dest_last) {
+  constexpr auto word_units = static_cast<std::ptrdiff_t> (details::units_per_word<latin1>);
+  for (; last - first >= word_units && dest_last - dest >= 2 * word_units; first += word_units) {
+    auto const w = details::load_word (first);
+    if ((w & details::non_ascii_mask<latin1>) == 0U) {
+      dest = std::transform (first, first + word_units, dest, [] (latin1 c) { return static_cast<char8> (c); });
+    } else {
+      dest = details::latin1_word_to_utf8 (w, dest);
+    }
+  }
+  for (; first != last; ++first) {
+    dest = t (*first, dest);
+  }
+  assert (dest <= dest_last);
+  return dest;
+}
+
+/// Converts the UTF-8 code units in the range [first, last) to Latin-1 writing
+/// the results to the buffer [dest, dest_last). The result is the same as that
+/// of the generic transcode() function, but whenever the transcoder is between
+/// code points, runs of ASCII are copied directly and the following word of
+/// input is checked to see whether it fits in Latin-1. If it does, the word is
+/// converted without passing through the UTF-8 decoder.
+///
+/// Note that transcoder::end_cp() is not called: more input may be passed to
+/// \p t after this function returns.
+///
+/// \param t  The transcoder to which the input code units are passed.
+/// \param first  The start of the range of code units to be transcoded.
+/// \param last  The end of the range of code units to be transcoded.
+/// \param dest  The start of the output buffer.
+/// \param dest_last  The end of the output buffer which must be large enough
+///   to hold the entire output sequence.
+/// \returns  Pointer one past the last element assigned.
+inline latin1* transcode (transcoder<char8, latin1>& t, char8 const* first, char8 const* last, latin1* dest,
+                          latin1* dest_last) {
+  constexpr auto word_units = static_cast<std::ptrdiff_t> (details::units_per_word<char8>);
+  while (first != last) {
+    if (!t.partial () && last - first >= word_units && dest_last - dest >= word_units) {
+      auto const w = details::load_word (first);
+      if ((w & details::non_ascii_mask<char8>) == 0U) {
+        auto const* const ascii_end = details::find_non_ascii (first, last);
+        dest = std::transform (first, ascii_end, dest, [] (char8 c) { return static_cast<latin1> (c); });
+        first = ascii_end;
+        continue;
+      }
+      if (auto const [consumed, out] = details::utf8_word_to_latin1 (w, dest); consumed > 0U) {
+        first += consumed;
+        dest = out;
+        continue;
+      }
+    }
+    dest = t (*first, dest);
+    ++first;
+  }
+  assert (dest <= dest_last);
+  return dest;
+}
+
+/// A sentinel which marks the end of a sequence of code units terminated by a
+/// code unit with the value zero, such as a C string. The terminator is not
+/// part of the sequence.
+struct null_terminated_t {
+  template <typename T> friend constexpr bool operator== (T const* p, null_terminated_t) noexcept {
+    return details::unit_value (*p) == 0U;
+  }
+  template <typename T> friend constexpr bool operator== (null_terminated_t, T const* p) noexcept {
+    return details::unit_value (*p) == 0U;
+  }
+  template <typename T> friend constexpr bool operator!= (T const* p, null_terminated_t) noexcept {
+    return details::unit_value (*p) != 0U;
+  }
+  template <typename T> friend constexpr bool operator!= (null_terminated_t, T const* p) noexcept {
+    return details::unit_value (*p) != 0U;
+  }
+};
+/// The sentinel for null-terminated sequences of code units.
+inline constexpr null_terminated_t null_terminated{};
+
+/// Passes the code units of the null-terminated sequence starting at \p first
+/// to transcoder \p t writing the results to \p dest. This is a single pass:
+/// the terminator is detected by the transcode loop itself, one code unit at a
+/// time, so that nothing beyond it is read. Runs of ASCII code units are copied
+/// directly to the output without being passed to the transcoder.
+///
+/// Note that transcoder::end_cp() is not called: more input may be passed to
+/// \p t after this function returns.
+///
+/// \param t  The transcoder to which the input code units are passed.
+/// \param first  The start of the null-terminated sequence of code units.
+/// \param dest  An output iterator to which the output sequence is written.
+/// \returns  Iterator one past the last element assigned.
+template <typename Transcoder, typename OutputIterator>
+ICUBABY_REQUIRES ((is_transcoder<Transcoder> && std::output_iterator<OutputIterator, typename Transcoder::output_type>))
+OutputIterator transcode (Transcoder& t, typename Transcoder::input_type const* first, null_terminated_t,
+                          OutputIterator dest) {
+  using output_type = typename Transcoder::output_type;
+  for (;;) {
+    auto const value = details::unit_value (*first);
+    if (value == 0U) {
+      return dest;
+    }
+    if (value < 0x80U && details::passes_ascii (t)) {
+      // Copy code units while they lie in [1, 0x7F]. The subtraction wraps the terminator to a
+      // large value so a single comparison ends the run at either a terminator or non-ASCII.
+      do {
+        *dest = static_cast<output_type> (*first);
+        ++dest;
+        ++first;
+      } while (details::unit_value (*first) - 1U < 0x7FU);
+      continue;
+    }
+    dest = t (*first, dest);
+    ++first;
+  }
+}
+
+namespace details {
+
+/// Returns true if a transcoder from encoding \p From is guaranteed not to be
+/// part way through a code point once it has consumed the code units
+/// [window_first, pos), irrespective of any input that preceded them. Input
+/// may be split at such a position and each part transcoded independently
+/// with results identical to transcoding the whole.
+///
+/// \param window_first  The start of the input that may be examined.
+/// \param pos  The candidate split position.
+/// \returns  True if the input may be split at \p pos.
+template <typename From> constexpr bool is_safe_split (From const* window_first, From const* pos) noexcept {
+  if constexpr (sizeof (From) == sizeof (char32_t) || std::is_same_v<From, latin1>) {
+    // UTF-32 and Latin-1 transcoders are stateless.
+    (void)window_first;
+    (void)pos;
+    return true;
+  } else if constexpr (sizeof (From) == sizeof (char16_t)) {
+    // Only a high surrogate leaves the transcoder waiting for more input.
+    return pos == window_first || !is_high_surrogate (static_cast<char32_t> (pos[-1]));
+  } else {
+    static_assert (sizeof (From) == sizeof (char8));
+    // The UTF-8 decoder's state is examined after it has consumed the final
+    // code units before the split starting in every one of its states. Since
+    // no UTF-8 sequence is longer than four code units, this window is
+    // usually enough for all of the states to converge.
+    constexpr auto window_size = std::ptrdiff_t{longest_sequence_v<char8>};
+    auto const* const window_start = pos - std::min (window_size, pos - window_first);
+    // Prefixes that drive the decoder into each of its non-accept states.
+    constexpr std::array<std::uint8_t, 8> primers{{0x00, 0xC2, 0xE0, 0xE1, 0xED, 0xF0, 0xF1, 0xF4}};
+    return std::all_of (primers.begin (), primers.end (), [window_start, pos] (std::uint8_t primer) {
+      transcoder<char8, char32_t> t;
+      auto out = t (static_cast<char8> (primer), counting_iterator{});
+      std::for_each (window_start, pos, [&t, &out] (From c) { out = t (static_cast<char8> (c), out); });
+      return !t.partial ();
+    });
+  }
+}
+
+/// Searches forward from \p pos for a position at which the code units
+/// [first, last) can be safely split. See is_safe_split().
+///
+/// \returns A position in the range [pos, last].
+template <typename From> constexpr From const* next_safe_split (From const* first, From const* last, From const* pos) {
+  assert (first <= pos && pos <= last);
+  for (; pos != last; ++pos) {
+    if (is_safe_split (first, pos)) {
+      break;
+    }
+  }
+  return pos;
+}
+
+/// Divides the code units [first, last) into up to \p parts roughly equal
+/// ranges, each of which can be transcoded independently of the others. The
+/// function \p f is called with the start of each range after the first
+/// followed by \p last.
+template <typename From, typename Function>
+void split (From const* first, From const* last, std::size_t parts, Function f) {
+  auto const size = static_cast<std::size_t> (last - first);
+  auto const* prev = first;
+  for (auto part = std::size_t{1}; part < parts; ++part) {
+    auto const* const ideal = first + size / parts * part;
+    if (ideal <= prev) {
+      continue;
+    }
+    auto const* const pos = next_safe_split (prev, last, ideal);
+    if (pos == last) {
+      break;
+    }
+    f (pos);
+    prev = pos;
+  }
+  f (last);
+}
+
+}  // end namespace details
+
+namespace details {
+
+/// Returns the number of code points that start in the code unit range
+/// [first, last). UTF-8 continuation bytes are detected a word at a time.
+template <typename T> constexpr std::ptrdiff_t count_code_point_starts (T const* first, T const* last) noexcept {
+  auto result = last - first;
+  if constexpr (sizeof (T) == sizeof (char8) && !std::is_same_v<T, latin1>) {
+    // A continuation byte has its top bit set and the next bit clear.
+    constexpr auto top_bits = broadcast<T> (0x80);
+    for (; last - first >= static_cast<std::ptrdiff_t> (units_per_word<T>); first += units_per_word<T>) {
+      auto const w = load_word (first);
+      result -= static_cast<std::ptrdiff_t> (count_bits (w & ~(w << 1U) & top_bits));
+    }
+  }
+  return result - std::count_if (first, last, [] (T c) { return !is_code_point_start (c); });
+}
+
+/// Passes the code units [first, last) to transcoder \p t discarding the
+/// output. Stops as soon as the transcoder detects ill-formed input.
+///
+/// \returns  The transcoder's well_formed() state.
+template <typename Transcoder, typename T> bool validate (Transcoder& t, T const* first, T const* last) {
+  auto out = counting_iterator{};
+  while (first != last && t.well_formed ()) {
+    if (unit_value (*first) < 0x80U && !t.partial ()) {
+      // ASCII code units are always valid.
+      first += find_non_ascii (first, last) - first;
+      if (first == last) {
+        break;
+      }
+    }
+    out = t (*first, out);
+    ++first;
+  }
+  return t.well_formed ();
+}
+
+}  // end namespace details
+
+/// Returns true if the code units [first, last) are a well formed sequence in
+/// the encoding given by their type: UTF-8 for char8, UTF-16 for char16_t, or
+/// UTF-32 for char32_t. This is equivalent to transcoding the input and
+/// checking well_formed() but stops at the first error and skips runs of ASCII
+/// a word at a time when the input is a contiguous array.
+///
+/// \param first  The start of the range of code units to examine.
+/// \param last  The end of the range of code units to examine.
+/// \returns  True if the input is well formed.
+template <typename InputIterator>
+ICUBABY_REQUIRES ((unicode_char_type<typename std::iterator_traits<InputIterator>::value_type>))
+bool is_well_formed (InputIterator first, InputIterator last) {
+  using value_type = typename std::iterator_traits<InputIterator>::value_type;
+  transcoder<value_type, char32_t> t;
+  auto out = details::counting_iterator{};
+  if constexpr (std::is_pointer_v<InputIterator>) {
+    if (!details::validate (t, first, last)) {
+      return false;
+    }
+  } else {
+    for (; first != last && t.well_formed (); ++first) {
+      out = t (*first, out);
+    }
+  }
+  t.end_cp (out);
+  return t.well_formed ();
+}
+
+/// Records the offset of the start of each line in a sequence of code units as
+/// both a code unit and a code point offset so that a position can be mapped to
+/// a line and column with a binary search. Lines are terminated by U+000A LINE
+/// FEED. The code units are presented in one or more calls to append() or to
+/// the overload of transcode() which accepts a line_index.
+///
+/// \tparam T  The type of the code units: char8, char16_t, or char32_t.
+template <typename T> class line_index {
+public:
+  /// A zero-based line number and a column within that line.
+  struct location {
+    std::size_t line = 0;
+    std::size_t column = 0;
+  };
+
+  /// Appends the code units [first, last) to the index. The code units are
+  /// searched for line feeds a word at a time.
+  ///
+  /// \param first  The start of the range of code units to be appended.
+  /// \param last  The end of the range of code units to be appended.
+  void append (T const* first, T const* last) {
+    constexpr auto word_units = static_cast<std::ptrdiff_t> (details::units_per_word<T>);
+    constexpr auto line_feeds = details::broadcast<T> (char32_t{0x0A});
+    auto const* segment = first;
+    auto const* pos = first;
+    for (; last - pos >= word_units; pos += word_units) {
+      if (details::zero_lanes<T> (details::load_word (pos) ^ line_feeds) != 0U) {
+        segment = this->scan (segment, pos, pos + word_units);
+      }
+    }
+    segment = this->scan (segment, pos, last);
+    code_points_ += static_cast<std::size_t> (details::count_code_point_starts (segment, last));
+    code_units_ += static_cast<std::size_t> (last - segment);
+  }
+  /// Appends a single code unit to the index.
+  ///
+  /// \param c  The code unit to be appended.
+  void append (T c) { this->append (&c, &c + 1); }
+
+  /// Appends \p units code units which contain no line feeds and which hold
+  /// the starts of \p code_points code points.
+  void skip (std::size_t units, std::size_t code_points) noexcept {
+    code_units_ += units;
+    code_points_ += code_points;
+  }
+  /// Appends a line feed, which starts a new line.
+  void line_feed () {
+    this->skip (1U, 1U);
+    unit_starts_.push_back (code_units_);
+    code_point_starts_.push_back (code_points_);
+  }
+
+  /// \returns  The number of lines.
+  [[nodiscard]] std::size_t size () const noexcept { return unit_starts_.size (); }
+  /// \returns  The code unit offset of the start of each line.
+  [[nodiscard]] std::vector<std::size_t> const& code_unit_starts () const noexcept { return unit_starts_; }
+  /// \returns  The code point offset of the start of each line.
+  [[nodiscard]] std::vector<std::size_t> const& code_point_starts () const noexcept { return code_point_starts_; }
+
+  /// \param offset  A code unit offset.
+  /// \returns  The line containing \p offset and its column in code units.
+  [[nodiscard]] location from_code_unit (std::size_t offset) const { return find (unit_starts_, offset); }
+  /// \param offset  A code point offset.
+  /// \returns  The line containing \p offset and its column in code points.
+  [[nodiscard]] location from_code_point (std::size_t offset) const { return find (code_point_starts_, offset); }
+
+private:
+  /// Records the start of a line following each line feed in [pos, last).
+  /// Code points in [segment, pos) have not yet been counted.
+  ///
+  /// \returns  The start of the code units that have not yet been counted.
+  T const* scan (T const* segment, T const* pos, T const* last) {
+    for (; pos != last; ++pos) {
+      if (details::unit_value (*pos) == 0x0AU) {
+        auto const* const next = pos + 1;
+        code_points_ += static_cast<std::size_t> (details::count_code_point_starts (segment, next));
+        code_units_ += static_cast<std::size_t> (next - segment);
+        unit_starts_.push_back (code_units_);
+        code_point_starts_.push_back (code_points_);
+        segment = next;
+      }
+    }
+    return segment;
+  }
+
+  static location find (std::vector<std::size_t> const& starts, std::size_t offset) {
+    auto const line = std::upper_bound (std::begin (starts), std::end (starts), offset) - 1;
+    return {static_cast<std::size_t> (line - std::begin (starts)), offset - *line};
+  }
+
+  /// The number of code units appended so far.
+  std::size_t code_units_ = 0;
+  /// The number of code points appended so far.
+  std::size_t code_points_ = 0;
+  std::vector<std::size_t> unit_starts_{0};
+  std::vector<std::size_t> code_point_starts_{0};
+};
+
+/// Passes the code units in the range [first, last) to transcoder \p t writing
+/// the results to \p dest and recording the start of each line in \p lines.
+/// When the input is a contiguous array, it is examined a word at a time: a
+/// single test of each word finds both non-ASCII code units and line feeds.
+/// Words of ASCII code units are copied directly to the output.
+///
+/// Note that transcoder::end_cp() is not called: more input may be passed to
+/// \p t after this function returns.
+///
+/// \param t  The transcoder to which the input code units are passed.
+/// \param first  The start of the range of code units to be transcoded.
+/// \param last  The end of the range of code units to be transcoded.
+/// \param dest  An output iterator to which the output sequence is written.
+/// \param lines  The index to which the input code units are appended.
+/// \returns  Iterator one past the last element assigned.
+template <typename Transcoder, typename InputIterator, typename OutputIterator>
+ICUBABY_REQUIRES ((is_transcoder<Transcoder> && std::output_iterator<OutputIterator, typename Transcoder::output_type>))
+OutputIterator transcode (Transcoder& t, InputIterator first, InputIterator last, OutputIterator dest,
+                          line_index<typename Transcoder::input_type>& lines) {
+  using input_type = typename Transcoder::input_type;
+  using output_type = typename Transcoder::output_type;
+  auto const unit = [&t, &lines] (input_type c, OutputIterator out) {
+    if (details::unit_value (c) == 0x0AU) {
+      lines.line_feed ();
+    } else {
+      lines.skip (1U, is_code_point_start (c) ? 1U : 0U);
+    }
+    return t (c, out);
+  };
+  if constexpr (std::is_pointer_v<InputIterator> &&
+                sizeof (typename std::iterator_traits<InputIterator>::value_type) == sizeof (input_type)) {
+    constexpr auto word_units = details::units_per_word<input_type>;
+    constexpr auto line_feeds = details::broadcast<input_type> (0x0A);
+    while (first != last) {
+      if (static_cast<std::size_t> (last - first) >= word_units && details::passes_ascii (t)) {
+        auto const w = details::load_word (first);
+        if ((w & details::non_ascii_mask<input_type>) == 0U) {
+          if (details::zero_lanes<input_type> (w ^ line_feeds) == 0U) {
+            lines.skip (word_units, word_units);
+          } else {
+            std::for_each (first, first + word_units, [&lines] (auto c) {
+              if (details::unit_value (c) == 0x0AU) {
+                lines.line_feed ();
+              } else {
+                lines.skip (1U, 1U);
+              }
+            });
+          }
+          dest = std::transform (first, first + word_units, dest, [] (auto c) { return static_cast<output_type> (c); });
+          first += word_units;
+          continue;
+        }
+      }
+      dest = unit (static_cast<input_type> (*first), dest);
+      ++first;
+    }
+    return dest;
+  } else {
+    for (; first != last; ++first) {
+      dest = unit (static_cast<input_type> (*first), dest);
+    }
+    return dest;
+  }
+}
+
+/// A sparse index of the code points in a sequence of code units which allows
+/// the start of any code point to be found without examining the sequence from
+/// the beginning. The offset of every stride'th code point is recorded so a
+/// lookup examines no more than stride code points. The index refers to, but
+/// does not own, the code units.
+///
+/// \tparam T  The type of the code units: char8, char16_t, or char32_t.
+template <typename T> class code_point_index {
+public:
+  /// The default number of code points between recorded offsets. With this
+  /// value the index occupies less than 1% of the space of the input.
+  static constexpr std::size_t default_stride = 1024;
+
+  constexpr code_point_index () noexcept = default;
+  /// Builds an index of the code units [first, last). Continuation code units
+  /// are counted a word at a time except in those words which hold a code
+  /// point whose offset is to be recorded.
+  ///
+  /// \param first  The start of the range of code units to index.
+  /// \param last  The end of the range of code units to index.
+  /// \param stride  The number of code points between recorded offsets.
+  code_point_index (T const* first, T const* last, std::size_t stride = default_stride)
+      : first_{first}, last_{last}, stride_{std::max (stride, std::size_t{1})} {
+    offsets_.reserve (static_cast<std::size_t> (last - first) / stride_ + 1U);
+    constexpr auto word_units = static_cast<std::ptrdiff_t> (details::units_per_word<T>);
+    auto next_mark = std::size_t{0};
+    for (auto const* pos = first; pos != last;) {
+      if (last - pos >= word_units) {
+        // Skip the word if none of the code points that start in it is to be recorded.
+        auto const starts = static_cast<std::size_t> (details::count_code_point_starts (pos, pos + word_units));
+        if (length_ + starts <= next_mark) {
+          length_ += starts;
+          pos += word_units;
+          continue;
+        }
+      }
+      if (is_code_point_start (*pos)) {
+        if (length_ == next_mark) {
+          offsets_.push_back (static_cast<std::size_t> (pos - first));
+          next_mark += stride_;
+        }
+        ++length_;
+      }
+      ++pos;
+    }
+  }
+
+  /// \returns The number of code points in the indexed sequence.
+  [[nodiscard]] constexpr std::size_t size () const noexcept { return length_; }
+  /// \returns The number of code points between recorded offsets.
+  [[nodiscard]] constexpr std::size_t stride () const noexcept { return stride_; }
+
+  /// Returns a pointer to the start of the pos'th code point.
+  ///
+  /// \param pos  The number of the code point to find.
+  /// \returns  A pointer to the first code unit of code point \p pos or the end
+  ///   of the indexed sequence if there is no such code point.
+  [[nodiscard]] T const* index (std::size_t pos) const {
+    if (pos >= length_) {
+      return last_;
+    }
+    return icubaby::index (first_ + offsets_[pos / stride_], last_, pos % stride_);
+  }
+
+  /// Returns the code units of \p count code points starting with code point
+  /// \p pos. The result is truncated at the end of the indexed sequence.
+  ///
+  /// \param pos  The number of the first code point.
+  /// \param count  The number of code points.
+  /// \returns  The code units of the code points [pos, pos + count).
+  [[nodiscard]] std::basic_string_view<T> substr (std::size_t pos, std::size_t count) const {
+    auto const* const first = this->index (pos);
+    auto const* const last =
+        count >= length_ - std::min (pos, length_) ? last_ : icubaby::index (first, last_, count);
+    return {first, static_cast<std::size_t> (last - first)};
+  }
+
+private:
+  T const* first_ = nullptr;
+  T const* last_ = nullptr;
+  std::size_t stride_ = default_stride;
+  /// The number of code points in the sequence.
+  std::size_t length_ = 0;
+  /// The offset of code point i * stride_ is offsets_[i].
+  std::vector<std::size_t> offsets_;
+};
+
+namespace details {
+
+/// Walks forward through the UTF-8 code units [first, last) to the last code
+/// point whose \p key is no greater than \p offset. A code point is a lead code
+/// unit and any continuation code units which follow it; only four byte
+/// sequences occupy two UTF-16 code units.
+///
+/// \tparam Position  A type with utf8, utf16, and code_point members.
+/// \param first  The start of the code units. This is the code point at \p pos.
+/// \param last  The end of the code units.
+/// \param pos  The position of the code point at \p first.
+/// \param key  The member of \p pos to be compared with \p offset.
+/// \param offset  The offset to be found.
+/// \returns  The position of the code point containing \p offset or of \p last.
+template <typename Position>
+constexpr Position walk_utf8 (char8 const* first, char8 const* last, Position pos, std::size_t Position::*key,
+                              std::size_t offset) noexcept {
+  while (first != last && pos.*key < offset) {
+    if (unit_value (*first) < 0x80U) {
+      // Each ASCII code unit advances all three offsets by one.
+      auto const limit = std::min (static_cast<std::size_t> (last - first), offset - pos.*key);
+      auto const ascii = static_cast<std::size_t> (find_non_ascii (first, first + limit) - first);
+      first += ascii;
+      pos.utf8 += ascii;
+      pos.utf16 += ascii;
+      pos.code_point += ascii;
+      continue;
+    }
+    auto const* const end = std::find_if (first + 1, last, [] (char8 c) { return is_code_point_start (c); });
+    auto const units = static_cast<std::size_t> (end - first);
+    // Only a four byte sequence encodes a code point outside the BMP and needs a surrogate pair.
+    auto const pair = units == 4U && unit_value (*first) >= 0xF0U && unit_value (*first) <= 0xF4U;
+    auto next = pos;
+    next.utf8 += units;
+    next.utf16 += pair ? 2U : 1U;
+    next.code_point += 1U;
+    if (next.*key > offset) {
+      break;
+    }
+    pos = next;
+    first = end;
+  }
+  return pos;
+}
+
+}  // end namespace details
+
+/// Translates between UTF-8 code unit, UTF-16 code unit, and code point offsets
+/// within a UTF-8 buffer without transcoding it. This is typically used where
+/// positions are exchanged in an encoding other than the one in which the text
+/// is stored (for example, the Language Server Protocol's UTF-16 positions).
+///
+/// The positions of every stride'th code point are recorded so that a lookup
+/// is a binary search followed by a walk of no more than stride code points.
+/// An offset which falls inside a code point maps to the start of that code
+/// point; an offset beyond the end of the buffer maps to its end. Code points
+/// are delimited as described for details::walk_utf8(). The map refers to, but
+/// does not own, the code units.
+class utf8_offset_map {
+public:
+  /// The offset of a code point expressed in each of the supported units.
+  struct position {
+    std::size_t utf8 = 0;
+    std::size_t utf16 = 0;
+    std::size_t code_point = 0;
+
+    friend constexpr bool operator== (position const& lhs, position const& rhs) noexcept {
+      return lhs.utf8 == rhs.utf8 && lhs.utf16 == rhs.utf16 && lhs.code_point == rhs.code_point;
+    }
+    friend constexpr bool operator!= (position const& lhs, position const& rhs) noexcept { return !(lhs == rhs); }
+  };
+
+  /// The default number of code points between recorded positions.
+  static constexpr std::size_t default_stride = 256;
+
+  utf8_offset_map () = default;
+  /// Builds a map of the UTF-8 code units [first, last).
+  ///
+  /// \param first  The start of the range of code units to map.
+  /// \param last  The end of the range of code units to map.
+  /// \param stride  The number of code points between recorded positions.
+  utf8_offset_map (char8 const* first, char8 const* last, std::size_t stride = default_stride)
+      : first_{first}, last_{last}, stride_{std::max (stride, std::size_t{1})} {
+    auto pos = position{};
+    auto const limit = std::numeric_limits<std::size_t>::max ();
+    auto next_mark = stride_;
+    while (pos.utf8 < this->code_units ()) {
+      // Walk up to the next position to be recorded. ASCII runs are skipped a word at a time.
+      pos = this->walk (pos, &position::code_point, next_mark);
+      if (pos.code_point == next_mark) {
+        marks_.push_back (pos);
+        next_mark = next_mark > limit - stride_ ? limit : next_mark + stride_;
+      }
+    }
+    end_ = pos;
+  }
+
+  /// \returns The position of the end of the buffer.
+  [[nodiscard]] constexpr position end () const noexcept { return end_; }
+
+  /// \param offset  An offset in UTF-8 code units.
+  /// \returns  The position of the code point containing \p offset.
+  [[nodiscard]] position from_utf8 (std::size_t offset) const { return this->find (&position::utf8, offset); }
+  /// \param offset  An offset in UTF-16 code units.
+  /// \returns  The position of the code point containing \p offset.
+  [[nodiscard]] position from_utf16 (std::size_t offset) const { return this->find (&position::utf16, offset); }
+  /// \param offset  An offset in code points.
+  /// \returns  The position of code point \p offset.
+  [[nodiscard]] position from_code_point (std::size_t offset) const {
+    return this->find (&position::code_point, offset);
+  }
+
+  /// Maps each of the UTF-8 offsets [first, last) to a position. The offsets
+  /// must be sorted in ascending order: they are mapped in a single sweep of
+  /// the buffer.
+  ///
+  /// \param first  The start of the range of offsets.
+  /// \param last  The end of the range of offsets.
+  /// \param out  An output iterator to which the resulting positions are written.
+  /// \returns  The output iterator after the positions have been written.
+  template <typename InputIterator, typename OutputIterator>
+  OutputIterator from_utf8 (InputIterator first, InputIterator last, OutputIterator out) const {
+    return this->sweep (&position::utf8, first, last, out);
+  }
+  /// Maps each of the sorted UTF-16 offsets [first, last) to a position.
+  ///
+  /// \param first  The start of the range of offsets.
+  /// \param last  The end of the range of offsets.
+  /// \param out  An output iterator to which the resulting positions are written.
+  /// \returns  The output iterator after the positions have been written.
+  template <typename InputIterator, typename OutputIterator>
+  OutputIterator from_utf16 (InputIterator first, InputIterator last, OutputIterator out) const {
+    return this->sweep (&position::utf16, first, last, out);
+  }
+  /// Maps each of the sorted code point offsets [first, last) to a position.
+  ///
+  /// \param first  The start of the range of offsets.
+  /// \param last  The end of the range of offsets.
+  /// \param out  An output iterator to which the resulting positions are written.
+  /// \returns  The output iterator after the positions have been written.
+  template <typename InputIterator, typename OutputIterator>
+  OutputIterator from_code_point (InputIterator first, InputIterator last, OutputIterator out) const {
+    return this->sweep (&position::code_point, first, last, out);
+  }
+
+private:
+  using key_type = std::size_t position::*;
+
+  [[nodiscard]] constexpr std::size_t code_units () const noexcept {
+    return static_cast<std::size_t> (last_ - first_);
+  }
+
+  [[nodiscard]] position walk (position const& pos, key_type key, std::size_t offset) const noexcept {
+    return details::walk_utf8 (first_ + pos.utf8, last_, pos, key, offset);
+  }
+
+  [[nodiscard]] position find (key_type key, std::size_t offset) const {
+    if (offset >= end_.*key) {
+      return end_;
+    }
+    auto const mark = std::upper_bound (std::begin (marks_), std::end (marks_), offset,
+                                        [key] (std::size_t o, position const& p) { return o < p.*key; });
+    assert (mark != std::begin (marks_));
+    return this->walk (*std::prev (mark), key, offset);
+  }
+
+  template <typename InputIterator, typename OutputIterator>
+  OutputIterator sweep (key_type key, InputIterator first, InputIterator last, OutputIterator out) const {
+    auto mark = std::size_t{0};
+    auto pos = position{};
+    for (; first != last; ++first) {
+      auto const offset = static_cast<std::size_t> (*first);
+      assert (offset >= pos.*key && "offsets must be sorted");
+      if (offset >= end_.*key) {
+        pos = end_;
+      } else {
+        // Jump to a later recorded position if one precedes the offset.
+        for (; mark + 1U < marks_.size () && marks_[mark + 1U].*key <= offset; ++mark) {
+        }
+        if (marks_[mark].*key > pos.*key) {
+          pos = marks_[mark];
+        }
+        pos = this->walk (pos, key, offset);
+      }
+      *(out++) = pos;
+    }
+    return out;
+  }
+
+  char8 const* first_ = nullptr;
+  char8 const* last_ = nullptr;
+  std::size_t stride_ = default_stride;
+  /// The position of code point i * stride_ is marks_[i].
+  std::vector<position> marks_{position{}};
+  position end_;
+};
+
+#if ICUBABY_HAVE_CLASS_NTTP && ICUBABY_HAVE_CONCEPTS
+
+namespace details {
+
+/// A string literal which may be used as a template argument.
+template <unicode_char_type C, std::size_t N> struct fixed_string {
+  // An implicit conversion allows a string literal to be used as the template argument.
+  // NOLINTNEXTLINE(hicpp-explicit-conversions,cppcoreguidelines-avoid-c-arrays,modernize-avoid-c-arrays)
+  constexpr fixed_string (C const (&str)[N]) noexcept {
+    std::copy (std::begin (str), std::end (str), std::begin (value));
+  }
+  std::array<C, N> value{};
+};
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays,hicpp-avoid-c-arrays,modernize-avoid-c-arrays)
+template <unicode_char_type C, std::size_t N> fixed_string (C const (&)[N]) -> fixed_string<C, N>;
+
+/// Transcodes the string literal \p Str, excluding its terminating null, to
+/// encoding \p To writing the result to \p dest.
+///
+/// \returns  A pair holding true if the input is well formed and the output
+///   iterator after the last element assigned.
+template <unicode_char_type To, fixed_string Str, typename OutputIterator>
+constexpr std::pair<bool, OutputIterator> transcode_literal (OutputIterator dest) {
+  using from_type = typename decltype (Str.value)::value_type;
+  transcoder<from_type, To> t;
+  auto const& str = Str.value;
+  for (auto it = str.begin (), last = str.end () - 1; it != last; ++it) {
+    dest = t (*it, dest);
+  }
+  dest = t.end_cp (dest);
+  return {t.well_formed (), dest};
+}
+
+}  // end namespace details
+
+/// The string literal \p Str converted to encoding \p To at compile time. The
+/// result is a std::array exactly large enough to hold the converted code
+/// units; it is not null terminated. Ill-formed input is a compile-time error.
+///
+/// ~~~
+/// constexpr auto hello = icubaby::literal<char16_t, u8"Hello, \u4E16\u754C">;
+/// static_assert (std::is_same_v<decltype (hello), std::array<char16_t, 9> const>);
+/// ~~~
+///
+/// \tparam To  The encoding of the result.
+/// \tparam Str  A UTF-8, UTF-16, or UTF-32 string literal.
+template <unicode_char_type To, details::fixed_string Str>
+inline constexpr auto literal = [] {
+  constexpr auto counted = [] {
+    auto const [well_formed, out] = details::transcode_literal<To, Str> (details::counting_iterator{});
+    return std::pair{well_formed, out.count ()};
+  }();
+  static_assert (counted.first, "the string literal is not well formed");
+  std::array<To, counted.second> result{};
+  (void)details::transcode_literal<To, Str> (result.begin ());
+  return result;
+}();
+
+#endif  // ICUBABY_HAVE_CLASS_NTTP && ICUBABY_HAVE_CONCEPTS
+
+/// Returns the maximum number of code units that can be produced by
+/// transcoding \p n code units from encoding \p From to \p To. This includes
+/// any U+FFFD REPLACEMENT CHARACTER output for ill-formed input and the output
+/// from end_cp(). A buffer of this size is always large enough to hold the
+/// result of transcoding.
+///
+/// \param n  The number of input code units.
+/// \returns  The maximum number of output code units.
+template <typename From, typename To>
+ICUBABY_REQUIRES ((unicode_char_type<From> && unicode_char_type<To>))
+constexpr std::size_t max_transcoded_size (std::size_t n) noexcept {
+  if constexpr (std::is_same_v<To, char8>) {
+    // A UTF-32 code unit may produce four UTF-8 code units; a Latin-1 code unit
+    // two; any other code unit produces at most U+FFFD REPLACEMENT CHARACTER
+    // (three code units).
+    if constexpr (std::is_same_v<From, latin1>) {
+      return n * 2U;
+    } else {
+      return n * (std::is_same_v<From, char32_t> ? 4U : 3U);
+    }
+  } else if constexpr (std::is_same_v<To, char16_t>) {
+    return n * (std::is_same_v<From, char32_t> ? 2U : 1U);
+  } else {
+    return n;
+  }
+}
+
+namespace details {
+
+/// Converts the ASCII code units [first, last) to type \p To by changing only
+/// their size. The input is processed in fixed-size blocks: compilers turn the
+/// inner loop into vector zero-extension (or packing) instructions.
+///
+/// \returns  Pointer one past the last element written.
+template <typename To, typename From> To* convert_ascii (From const* first, From const* last, To* dest) noexcept {
+  constexpr auto block = std::ptrdiff_t{16};
+  for (; last - first >= block; first += block, dest += block) {
+    for (auto ctr = std::ptrdiff_t{0}; ctr < block; ++ctr) {
+      dest[ctr] = static_cast<To> (first[ctr]);
+    }
+  }
+  return std::transform (first, last, dest, [] (From c) { return static_cast<To> (c); });
+}
+
+}  // end namespace details
+
+/// The result of transcode_string(). When no conversion was needed the result
+/// borrows the caller's input and nothing is allocated; otherwise it owns a
+/// string holding the transcoded output.
+///
+/// \tparam C  The output code unit type.
+template <typename C> class borrowed_or_owned_string {
+public:
+  static_assert (!std::is_same_v<C, latin1>, "Latin-1 has no std::basic_string");
+  using view_type = std::basic_string_view<C>;
+  using string_type = std::basic_string<C>;
+
+  /// Constructs a result which refers to \p borrowed. The underlying data must
+  /// outlive this object.
+  explicit constexpr borrowed_or_owned_string (view_type borrowed) noexcept : borrowed_{borrowed} {}
+  /// Constructs a result which owns \p owned.
+  explicit borrowed_or_owned_string (string_type owned) : owned_{std::move (owned)} {}
+
+  /// \returns  True if the result refers to the input of the conversion and
+  ///   false if it owns its own storage.
+  [[nodiscard]] constexpr bool borrowed () const noexcept { return !owned_.has_value (); }
+  /// \returns  A view of the transcoded code units.
+  [[nodiscard]] constexpr view_type view () const noexcept { return owned_ ? view_type{*owned_} : borrowed_; }
+  /// \returns  The transcoded code units as a string. An owned string is moved
+  ///   out of the result; a borrowed one is copied.
+  [[nodiscard]] string_type str () && { return owned_ ? std::move (*owned_) : string_type{borrowed_}; }
+
+private:
+  view_type borrowed_;
+  std::optional<string_type> owned_;
+};
+
+/// Converts \p input from encoding \p From to \p To. The input is first
+/// scanned a word at a time to see whether it consists only of ASCII code
+/// units. If it does and the two encodings are the same, the result simply
+/// borrows the input. ASCII input that must be widened or narrowed is converted
+/// by details::convert_ascii() rather than by the transcoder. Anything else is
+/// passed to a transcoder. Owned output is allocated once at its exact size:
+/// non-ASCII input is transcoded twice, first to count the output code units
+/// and then to write them. When std::basic_string<>::resize_and_overwrite() is
+/// available the output is written directly into the string's storage without
+/// first being zero-filled.
+///
+/// \tparam To  The output encoding.
+/// \tparam From  The input encoding.
+/// \param input  The code units to be converted.
+/// \param well_formed  If not null, receives true if the input was well formed.
+/// \returns  A result which either borrows from \p input or owns the output.
+template <typename To, typename From>
+ICUBABY_REQUIRES ((unicode_char_type<From> && unicode_char_type<To> && !std::is_same_v<From, latin1> &&
+                   !std::is_same_v<To, latin1>))
+borrowed_or_owned_string<To> transcode_string (std::basic_string_view<From> input, bool* well_formed = nullptr) {
+  static_assert (!std::is_same_v<From, latin1>, "Latin-1 has no std::basic_string_view");
+  auto const* const first = input.data ();
+  auto const* const last = first + input.size ();
+  if (details::find_non_ascii (first, last) == last) {
+    if (well_formed != nullptr) {
+      *well_formed = true;
+    }
+    if constexpr (std::is_same_v<From, To>) {
+      return borrowed_or_owned_string<To>{input};
+    } else {
+#if ICUBABY_HAVE_RESIZE_AND_OVERWRITE
+      std::basic_string<To> out;
+      out.resize_and_overwrite (input.size (), [first, last] (To* const dest, std::size_t const size) {
+        details::convert_ascii (first, last, dest);
+        return size;
+      });
+#else
+      // The iterator constructor allocates once and converts each code unit as
+      // it is copied.
+      std::basic_string<To> out (first, last);
+#endif
+      return borrowed_or_owned_string<To>{std::move (out)};
+    }
+  }
+  transcoder<From, To> counter;
+  auto const size = counter.end_cp (transcode (counter, first, last, details::counting_iterator{})).count ();
+  // Pass pointers (rather than string iterators) so that transcode() can use
+  // its word-at-a-time paths.
+  auto const convert = [first, last] (To* const dest, std::size_t const n) {
+    transcoder<From, To> t;
+    auto const* const end = t.end_cp (transcode (t, first, last, dest));
+    assert (static_cast<std::size_t> (end - dest) == n);
+    (void)end;
+    return n;
+  };
+  std::basic_string<To> out;
+#if ICUBABY_HAVE_RESIZE_AND_OVERWRITE
+  out.resize_and_overwrite (size, convert);
+#else
+  out.resize (size);
+  convert (out.data (), size);
+#endif
+  if (well_formed != nullptr) {
+    *well_formed = counter.well_formed ();
+  }
+  return borrowed_or_owned_string<To>{std::move (out)};
+}
+
+namespace details {
+
+/// The state of one of the streams decoded by decode_interleaved(). This is
+/// the same automaton as utf8_decoder, but a code point is written on every
+/// step and the output pointer advanced only when one is complete. This avoids
+/// data-dependent branches so that the steps of different streams overlap.
+template <typename Engine> struct utf8_stream {
+  static_assert (Engine::accept == 0);
+
+  char32_t* out = nullptr;
+  std::uint_least32_t code_point = 0;
+  std::uint_least32_t state = Engine::accept;
+
+  /// Decodes a single code unit. The element at out must be writable even if
+  /// no code point is produced. Selections are made with masks rather than
+  /// conditionals to stop the compiler from introducing branches.
+  ///
+  /// \returns  One if the code unit was rejected as ill-formed and zero otherwise.
+  constexpr std::uint_least32_t step (char8 code_unit) noexcept {
+    auto const ucu = static_cast<std::uint8_t> (code_unit);
+    auto const continuing = 0U - static_cast<std::uint_least32_t> (state != Engine::accept);
+    code_point = ((((ucu & 0x3FU) | (code_point << 6U)) & continuing) | (Engine::lead_bits (ucu) & ~continuing)) &
+                 ((std::uint_least32_t{1} << code_point_bits) - 1U);
+    state = Engine::next (static_cast<std::uint_least8_t> (state), ucu);
+    auto const reject = static_cast<std::uint_least32_t> (state == Engine::reject);
+    auto const complete = reject | static_cast<std::uint_least32_t> (state == Engine::accept);
+    *out = static_cast<char32_t> (code_point ^ ((code_point ^ replacement_char) & (0U - reject)));
+    out += complete;
+    state &= reject - 1U;
+    return reject;
+  }
+  /// Ends the stream: a partial code point is replaced by U+FFFD.
+  ///
+  /// \returns  One if the stream ended with a partial code point and zero otherwise.
+  constexpr std::uint_least32_t end () noexcept {
+    if (state == Engine::accept) {
+      return 0U;
+    }
+    *(out++) = replacement_char;
+    state = Engine::accept;
+    return 1U;
+  }
+};
+
+/// Steps each of the streams \p streams through the first \p count code units
+/// of its segment. The streams are copied to locals and the loop over them is
+/// unrolled so that the compiler can keep their state in registers.
+///
+/// \returns  Non-zero if any of the streams encountered ill-formed input.
+template <typename Engine, std::size_t Streams, std::size_t... Indices>
+std::uint_least32_t step_lockstep (std::array<utf8_stream<Engine>, Streams>& streams,
+                                   std::array<char8 const*, Streams + 1> const& bounds, std::size_t count,
+                                   std::index_sequence<Indices...> /*unused*/) noexcept {
+  auto local = streams;
+  auto rejected = std::uint_least32_t{0};
+  for (auto ctr = std::size_t{0}; ctr < count; ++ctr) {
+    rejected |= (std::get<Indices> (local).step (std::get<Indices> (bounds)[ctr]) | ...);
+  }
+  streams = local;
+  return rejected;
+}
+
+}  // end namespace details
+
+/// Decodes the UTF-8 code units [first, last) to UTF-32. The input is divided
+/// into \p Streams segments at code point boundaries and the segments are
+/// decoded in lockstep within a single loop. Each stream's state depends on its
+/// previous state, but the streams are independent of one another, so the
+/// processor can overlap their work. This gives instruction-level parallelism
+/// where vector instructions are not available. The output is identical to
+/// that of transcoder<char8, char32_t>.
+///
+/// \tparam Streams  The number of segments decoded together.
+/// \tparam Engine  The DFA engine used to decode: table_dfa or shift_dfa. The
+///   streams already hide the latency of each transition, so the two engines
+///   perform alike here and the default is the one with the smaller table.
+/// \param first  The start of the range of code units to be decoded.
+/// \param last  The end of the range of code units to be decoded.
+/// \param dest  The buffer to which the output is written. It must have room for
+///   at least max_transcoded_size<char8, char32_t>(last - first) elements.
+/// \param well_formed  Either nullptr or a pointer to a bool which is set to
+///   true if the input was well formed and false otherwise.
+/// \returns  Pointer one past the last element written.
+template <std::size_t Streams = 4, typename Engine = table_dfa>
+char32_t* decode_interleaved (char8 const* first, char8 const* last, char32_t* dest, bool* well_formed = nullptr) {
+  static_assert (Streams > 0);
+  // Segments smaller than this are not worth decoding separately.
+  constexpr auto min_segment_size = std::size_t{64};
+  // The input is split into segments [bounds[i], bounds[i + 1]).
+  std::array<char8 const*, Streams + 1> bounds{};
+  bounds[0] = first;
+  auto segments = std::size_t{0};
+  if (static_cast<std::size_t> (last - first) >= Streams * min_segment_size) {
+    details::split (first, last, Streams, [&bounds, &segments] (char8 const* pos) { bounds[++segments] = pos; });
+  }
+  if (segments != Streams) {
+    // The input is too small to split (or has no safe split points).
+    details::utf8_stream<Engine> stream{dest};
+    auto rejected = std::uint_least32_t{0};
+    std::for_each (first, last, [&stream, &rejected] (char8 c) { rejected |= stream.step (c); });
+    rejected |= stream.end ();
+    if (well_formed != nullptr) {
+      *well_formed = rejected == 0U;
+    }
+    return stream.out;
+  }
+
+  // Each segment's output is written at the same offset in dest as its input.
+  // A code unit never produces more than one code point so a stream's output
+  // cannot overwrite that of the stream which follows.
+  std::array<details::utf8_stream<Engine>, Streams> streams{};
+  auto common = static_cast<std::size_t> (last - first);
+  for (auto s = std::size_t{0}; s < Streams; ++s) {
+    streams[s].out = dest + (bounds[s] - first);
+    common = std::min (common, static_cast<std::size_t> (bounds[s + 1] - bounds[s]));
+  }
+  // Step the streams in lockstep for as long as every segment has input.
+  auto rejected = details::step_lockstep (streams, bounds, common, std::make_index_sequence<Streams>{});
+  // Finish each segment and gather the output.
+  auto* out = dest;
+  for (auto s = std::size_t{0}; s < Streams; ++s) {
+    auto& stream = streams[s];
+    std::for_each (bounds[s] + common, bounds[s + 1], [&stream, &rejected] (char8 c) { rejected |= stream.step (c); });
+    rejected |= stream.end ();
+    auto* const segment_out = dest + (bounds[s] - first);
+    out = out == segment_out ? stream.out : std::copy (segment_out, stream.out, out);
+  }
+  if (well_formed != nullptr) {
+    *well_formed = rejected == 0U;
+  }
+  return out;
+}
+
+/// Transcodes a column of strings stored as a single contiguous buffer of code
+/// units together with an array of offsets (the layout used by Apache Arrow).
+/// String i occupies the code units [data + offsets[i], data + offsets[i + 1]).
+/// The output is written using the same layout.
+///
+/// Each string is transcoded independently so that ill-formed input cannot
+/// affect its neighbors, but the work is done in a single pass over the data.
+/// Runs of ASCII strings are detected a word at a time and copied directly to
+/// the output without regard to the string boundaries.
+///
+/// \param data  The column's code units.
+/// \param offsets  An array of count + 1 offsets into \p data.
+/// \param count  The number of strings in the column.
+/// \param out_data  The buffer to which the output code units are written. It
+///   must have room for at least max_transcoded_size<From, To>(offsets[count] -
+///   offsets[0]) elements.
+/// \param out_offsets  An array of count + 1 elements to which the offsets of
+///   the output strings are written.
+/// \param validity  Either nullptr or a bitmap of (count + 7) / 8 bytes. Bit i
+///   (counting from the least significant bit of the first byte) is set if
+///   string i was well formed and cleared otherwise.
+/// \returns  The number of code units written to \p out_data.
+template <typename From, typename To, typename Offset>
+ICUBABY_REQUIRES ((unicode_char_type<From> && unicode_char_type<To> && std::integral<Offset>))
+std::size_t transcode_column (From const* data, Offset const* offsets, std::size_t count, To* out_data,
+                              Offset* out_offsets, std::uint8_t* validity) {
+  auto set_valid = [validity] (std::size_t index, bool valid) {
+    if (validity != nullptr) {
+      auto const mask = static_cast<std::uint8_t> (1U << (index % 8U));
+      validity[index / 8U] = static_cast<std::uint8_t> (valid ? validity[index / 8U] | mask
+                                                              : validity[index / 8U] & ~mask);
+    }
+  };
+  auto* out = out_data;
+  auto const* const column_last = data + offsets[count];
+  out_offsets[0] = 0;
+  for (auto index = std::size_t{0}; index < count;) {
+    auto const* const first = data + offsets[index];
+    auto const* const last = data + offsets[index + 1U];
+    if (first != last && details::unit_value (*first) < 0x80U) {
+      // Copy as many entirely ASCII strings as possible.
+      auto const* const ascii_end = details::find_non_ascii (first, column_last);
+      if (last <= ascii_end) {
+        for (; index < count && data + offsets[index + 1U] <= ascii_end; ++index) {
+          out = std::transform (data + offsets[index], data + offsets[index + 1U], out,
+                                [] (From c) { return static_cast<To> (c); });
+          out_offsets[index + 1U] = static_cast<Offset> (out - out_data);
+          set_valid (index, true);
+        }
+        continue;
+      }
+    }
+    transcoder<From, To> t;
+    out = t.end_cp (transcode (t, first, last, out));
+    out_offsets[index + 1U] = static_cast<Offset> (out - out_data);
+    set_valid (index, t.well_formed ());
+    ++index;
+  }
+  return static_cast<std::size_t> (out - out_data);
+}
+
+/// The result of a call to sniff().
+struct sniff_result {
+  /// The encoding of the input bytes.
+  encoding enc = encoding::unknown;
+  /// The number of bytes occupied by the byte order mark. Zero if the input
+  /// did not begin with a byte order mark.
+  std::size_t bom_size = 0;
+};
+
+namespace details {
+
+/// Tallies the number of zero bytes at each position (modulo 4) of the byte
+/// sequence [first, last) whose length must be a multiple of four.
+template <typename InputIterator>
+std::array<std::size_t, 4> count_zero_bytes (InputIterator first, InputIterator last) {
+  std::array<std::size_t, 4> zeros{};
+  using value_type = typename std::iterator_traits<InputIterator>::value_type;
+  if constexpr (std::is_pointer_v<InputIterator>) {
+    static_assert (units_per_word<value_type> == 8U);
+    constexpr auto lane0 = std::uint64_t{0x00000080'00000080};
+    for (; last - first >= 8; first += 8) {
+      auto const z = zero_lanes<value_type> (load_word (first));
+      if (z != 0U) {
+        for (auto lane = 0U; lane < zeros.size (); ++lane) {
+          zeros[lane] += count_bits (z & (lane0 << (8U * lane)));
+        }
+      }
+    }
+  }
+  for (auto lane = std::size_t{0}; first != last; ++first, lane = (lane + 1U) % zeros.size ()) {
+    if (unit_value (*first) == 0U) {
+      ++zeros[lane];
+    }
+  }
+  return zeros;
+}
+
+/// Returns true if the byte sequence [first, last) is valid UTF-8. If \p
+/// truncated is true, the sequence is permitted to end part way through a
+/// code point.
+template <typename InputIterator> bool is_utf8 (InputIterator first, InputIterator last, bool truncated) {
+  transcoder<char8, char32_t> t;
+  auto const out = transcode (t, first, last, counting_iterator{});
+  if (!truncated) {
+    t.end_cp (out);
+  }
+  return t.well_formed ();
+}
+
+}  // end namespace details
+
+/// The default number of bytes examined by sniff() when the input does not
+/// begin with a byte order mark.
+inline constexpr std::size_t sniff_window = 4096;
+
+/// Determines the encoding of the bytes [first, last). If the input begins with
+/// a byte order mark, that determines the encoding. Otherwise the first \p
+/// window bytes are examined: the distribution of zero bytes is used to detect
+/// UTF-16 and UTF-32 (in either byte order) and, failing that, the bytes are
+/// checked for UTF-8 validity.
+///
+/// \param first  The start of the range of bytes to examine.
+/// \param last  The end of the range of bytes to examine.
+/// \param window  The maximum number of bytes to be examined.
+/// \returns  The encoding of the input and the size of its byte order mark.
+template <typename ForwardIterator>
+ICUBABY_REQUIRES ((std::forward_iterator<ForwardIterator>))
+sniff_result sniff (ForwardIterator first, ForwardIterator last, std::size_t window = sniff_window) {
+  static_assert (sizeof (typename std::iterator_traits<ForwardIterator>::value_type) == 1,
+                 "sniff() input must be a sequence of bytes");
+  auto const size = static_cast<std::size_t> (std::distance (first, last));
+  auto starts_with = [first, size] (std::initializer_list<std::uint8_t> bytes) {
+    return size >= bytes.size () && std::equal (bytes.begin (), bytes.end (), first, [] (std::uint8_t a, auto b) {
+             return a == details::unit_value (b);
+           });
+  };
+  // Note that the UTF-32LE byte order mark must be checked before UTF-16LE.
+  if (starts_with ({0xEF, 0xBB, 0xBF})) {
+    return {encoding::utf8, 3};
+  }
+  if (starts_with ({0x00, 0x00, 0xFE, 0xFF})) {
+    return {encoding::utf32be, 4};
+  }
+  if (starts_with ({0xFF, 0xFE, 0x00, 0x00})) {
+    return {encoding::utf32le, 4};
+  }
+  if (starts_with ({0xFE, 0xFF})) {
+    return {encoding::utf16be, 2};
+  }
+  if (starts_with ({0xFF, 0xFE})) {
+    return {encoding::utf16le, 2};
+  }
+
+  auto const n = std::min (size, window);
+  auto const quads = n / 4U;
+  auto const z = details::count_zero_bytes (first, std::next (first, static_cast<std::ptrdiff_t> (quads * 4U)));
+  if (quads > 0U) {
+    // The most significant byte of a UTF-32 code unit is always zero and the
+    // next byte is zero for any code point in the BMP.
+    if (z[3] == quads && z[2] * 2U >= quads) {
+      return {encoding::utf32le, 0};
+    }
+    if (z[0] == quads && z[1] * 2U >= quads) {
+      return {encoding::utf32be, 0};
+    }
+    // In UTF-16 text, characters from the ASCII and Latin-1 ranges have a zero
+    // most-significant byte. Look for a strong bias of zeros to odd or even
+    // byte positions.
+    auto const even = z[0] + z[2];
+    auto const odd = z[1] + z[3];
+    auto const threshold = std::max (std::size_t{1}, quads / 8U);
+    if (odd >= threshold && odd > even * 4U) {
+      return {encoding::utf16le, 0};
+    }
+    if (even >= threshold && even > odd * 4U) {
+      return {encoding::utf16be, 0};
+    }
+  }
+  return {details::is_utf8 (first, std::next (first, static_cast<std::ptrdiff_t> (n)), n < size) ? encoding::utf8
+                                                                                                   : encoding::unknown,
+          0};
+}
+
+/// Takes a sequence of bytes in any of the encodings given by
+/// icubaby::encoding and converts them to the encoding given by \p To. Bytes
+/// are assembled into code units according to the selected encoding and byte
+/// order before being passed to the transcoder for that encoding.
+/// encoding::unknown is treated as UTF-8.
+template <typename To> class byte_transcoder {
+public:
+  using input_type = std::byte;
+  using output_type = To;
+
+  constexpr byte_transcoder () noexcept : byte_transcoder (encoding::utf8) {}
+  explicit constexpr byte_transcoder (encoding enc) noexcept
+      : enc_{enc == encoding::unknown ? encoding::utf8 : enc} {}
+
+  /// \param b  A byte of input.
+  /// \param dest  Iterator to which the output should be written.
+  /// \returns  Iterator one past the last element assigned.
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr OutputIterator operator() (input_type b, OutputIterator dest) {
+    auto const value = static_cast<std::uint_least32_t> (b);
+    switch (enc_) {
+    case encoding::utf16be:
+    case encoding::utf32be: unit_ = (unit_ << 8U) | value; break;
+    case encoding::utf16le:
+    case encoding::utf32le: unit_ |= value << (8U * bytes_); break;
+    case encoding::unknown:
+    case encoding::utf8: return t8_ (static_cast<char8> (value), dest);
+    }
+    if (static_cast<unsigned> (++bytes_) < this->unit_size ()) {
+      return dest;
+    }
+    auto const unit = unit_;
+    unit_ = 0;
+    bytes_ = 0;
+    if (this->unit_size () == sizeof (char16_t)) {
+      return t16_ (static_cast<char16_t> (unit), dest);
+    }
+    return t32_ (static_cast<char32_t> (unit), dest);
+  }
+
+  /// Call once the entire input sequence has been fed to operator(). This
+  /// function ensures that the sequence did not end with a partial code point
+  /// or code unit.
+  ///
+  /// \param dest  An output iterator to which the output sequence is written.
+  /// \returns  Iterator one past the last element assigned.
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr OutputIterator end_cp (OutputIterator dest) {
+    dest = t8_.end_cp (t16_.end_cp (t32_.end_cp (dest)));
+    if (bytes_ != 0) {
+      unit_ = 0;
+      bytes_ = 0;
+      well_formed_ = false;
+      dest = transcoder<char32_t, output_type>{} (replacement_char, dest);
+    }
+    return dest;
+  }
+
+  template <typename OutputIterator>
+  ICUBABY_REQUIRES ((std::output_iterator<OutputIterator, output_type>))
+  constexpr iterator<byte_transcoder, OutputIterator> end_cp (iterator<byte_transcoder, OutputIterator> dest) {
+    auto t = dest.transcoder ();
+    assert (t == this);
+    return {t, t->end_cp (dest.base ())};
+  }
+
+  /// \returns The encoding of the input bytes.
+  [[nodiscard]] constexpr encoding input_encoding () const noexcept { return enc_; }
+  /// \returns True if the input bytes represented well formed text.
+  [[nodiscard]] constexpr bool well_formed () const noexcept {
+    return well_formed_ && t8_.well_formed () && t16_.well_formed () && t32_.well_formed ();
+  }
+  [[nodiscard]] constexpr bool partial () const noexcept {
+    return bytes_ != 0 || t8_.partial () || t16_.partial () || t32_.partial ();
+  }
+
+private:
+  [[nodiscard]] constexpr unsigned unit_size () const noexcept {
+    return enc_ == encoding::utf32be || enc_ == encoding::utf32le ? 4U : 2U;
+  }
+
+  encoding enc_;
+  bool well_formed_ = true;
+  /// The number of bytes of the current UTF-16 or UTF-32 code unit that have
+  /// been received.
+  std::uint_least8_t bytes_ = 0;
+  /// The UTF-16 or UTF-32 code unit being assembled.
+  std::uint_least32_t unit_ = 0;
+  transcoder<char8, To> t8_;
+  transcoder<char16_t, To> t16_;
+  transcoder<char32_t, To> t32_;
+};
+
+#if ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+namespace ranges {
+
+/// A transcode_view buffering policy which produces the output one code point
+/// at a time. Input is always passed to the transcoder one code unit at a time,
+/// even when the base range is contiguous.
+struct unbuffered {};
+/// A transcode_view buffering policy which, each time the view's output is
+/// exhausted, transcodes enough input to produce up to \p Size code units.
+/// This amortizes the cost of refilling the buffer over many code points. If the
+/// base range is contiguous, each refill uses the bulk icubaby::transcode()
+/// function and its ASCII fast path.
+template <std::size_t Size> struct buffered {};
+/// A transcode_view policy for use only when the input and output encodings are the same and the
+/// input is already known to be well formed. No view is created: the range is passed through
+/// unchanged and so retains its iterator category (random access, contiguous, and so on).
+struct unchecked {};
+
+namespace details {
+
+/// The number of code units that the transcoder can produce in response to a
+/// single input code unit together with any output from a following call to
+/// end_cp(). This is two code points. The UTF-16 decoder emits a REPLACEMENT
+/// CHARACTER followed by the code point that ended an unpaired high surrogate.
+/// The UTF-8 decoder instead discards the code unit which ends an ill-formed
+/// sequence, so it produces no more than one code point per code unit, but
+/// end_cp() may then add a REPLACEMENT CHARACTER for a truncated sequence.
+template <unicode_char_type ToEncoding>
+inline constexpr std::size_t max_output_per_unit = 2U * longest_sequence_v<ToEncoding>;
+
+template <typename Buffering, unicode_char_type ToEncoding> struct buffer_size;
+template <unicode_char_type ToEncoding>
+struct buffer_size<unbuffered, ToEncoding> : std::integral_constant<std::size_t, max_output_per_unit<ToEncoding>> {};
+template <std::size_t Size, unicode_char_type ToEncoding>
+struct buffer_size<buffered<Size>, ToEncoding>
+    : std::integral_constant<std::size_t, std::max (Size, max_output_per_unit<ToEncoding>)> {};
+
+/// Steps backwards from \p pos to the start of the preceding code point. No more than the
+/// number of code units in the longest sequence are examined so that ill-formed input cannot
+/// cause an unbounded search.
+///
+/// \param first  The start of the input.
+/// \param pos  The position from which to step backwards. Must not be equal to \p first.
+/// \returns  The start of the code point preceding \p pos.
+template <unicode_char_type FromEncoding, std::bidirectional_iterator Iterator>
+constexpr Iterator previous_code_point_start (Iterator const& first, Iterator pos) {
+  assert (pos != first);
+  --pos;
+  for (auto ctr = longest_sequence_v<FromEncoding> - 1U;
+       ctr > 0U && pos != first && !is_code_point_start (static_cast<FromEncoding> (*pos)); --ctr) {
+    --pos;
+  }
+  return pos;
+}
+
+/// True if a transcode_view of \p View with the given buffering policy can be traversed in both
+/// directions. Stepping backwards transcodes one code point at a time so iterator positions are
+/// only consistent in both directions if the forward direction does the same.
+template <typename View, typename Buffering>
+concept reversible = std::ranges::bidirectional_range<View> && std::same_as<Buffering, unbuffered>;
+
+/// True if the code units of \p View are stored contiguously as \p FromEncoding and may be
+/// passed directly to icubaby::transcode().
+template <typename FromEncoding, typename View>
+concept bulk_transcodable =
+    std::ranges::contiguous_range<View> &&
+    std::sized_sentinel_for<std::ranges::sentinel_t<View const>, std::ranges::iterator_t<View const>> &&
+    std::same_as<std::ranges::range_value_t<View>, FromEncoding>;
+
+}  // end namespace details
+
+/// A view of the code units of \p View transcoded from \p FromEncoding to \p ToEncoding.
+///
+/// Only a view with the buffered<> policy and a contiguous base range takes the bulk (word at a
+/// time) path. The default unbuffered policy transcodes one code unit per increment so that the
+/// view can also be traversed backwards.
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View,
+          typename Buffering = unbuffered>
+  requires std::ranges::view<View>
+class transcode_view : public std::ranges::view_interface<transcode_view<FromEncoding, ToEncoding, View, Buffering>> {
+public:
+  class iterator;
+  class sentinel;
+
+  transcode_view () requires std::default_initializable<View> = default;
+  constexpr explicit transcode_view (View base) : base_ (std::move (base)) {}
+
+  constexpr View base () const& requires std::copy_constructible<View> { return base_; }
+  constexpr View base () && { return std::move (base_); }
+
+  /// \returns An upper bound on the number of code units that the view will produce. This is
+  ///   suitable for reserving container storage before the view's output is copied to it.
+  constexpr std::size_t reserve_hint () const requires std::ranges::sized_range<View const> {
+    return max_transcoded_size<FromEncoding, ToEncoding> (static_cast<std::size_t> (std::ranges::size (base_)));
+  }
+  /// Counts the code units that the view will produce. This is a pass over the input (using the
+  /// bulk transcoder if the base is contiguous) but the output is not stored.
+  ///
+  /// \returns The exact number of code units that the view will produce.
+  constexpr std::size_t exact_size () const requires std::ranges::forward_range<View const> {
+    transcoder<FromEncoding, ToEncoding> t;
+    icubaby::details::counting_iterator out;
+    if constexpr (details::bulk_transcodable<FromEncoding, View>) {
+      auto const* const first = std::ranges::data (base_);
+      out = icubaby::transcode (t, first, first + std::ranges::size (base_), out);
+    } else {
+      for (auto const c : base_) {
+        out = t (c, out);
+      }
+    }
+    return t.end_cp (out).count ();
+  }
+
+  constexpr auto begin () const requires std::ranges::forward_range<View> {
+    return iterator{*this, std::ranges::begin (base_)};
+  }
+  constexpr auto end () const requires std::ranges::forward_range<View> {
+    if constexpr (std::ranges::common_range<View>) {
+      return iterator{*this, std::ranges::end (base_)};
+    } else {
+      return sentinel{*this};
+    }
+  }
+
+  /// A view of a single-pass input range is itself single-pass: it holds the base iterator and
+  /// the transcoder's state and begin() may be called only once.
+  constexpr auto begin () requires (!std::ranges::forward_range<View>) {
+    input_.start (std::ranges::begin (base_), std::ranges::end (base_));
+    return input_iterator{*this};
+  }
+  constexpr std::default_sentinel_t end () requires (!std::ranges::forward_range<View>) {
+    return std::default_sentinel;
+  }
+
+private:
+  class input_iterator;
+  class input_state;
+  struct no_input_state {};
+
+  [[no_unique_address]] View base_ = View ();
+  [[no_unique_address]] std::conditional_t<std::ranges::forward_range<View>, no_input_state, input_state> input_{};
+};
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View,
+          typename Buffering>
+  requires std::ranges::view<View>
+class transcode_view<FromEncoding, ToEncoding, View, Buffering>::iterator {
+public:
+  // Dereferencing the iterator yields a value rather than a reference: the output code units are
+  // held by the iterator itself, so a reference would dangle when taken from a temporary copy
+  // (as std::reverse_iterator does). The C++17 iterator requirements insist that a forward
+  // iterator's reference type is a true reference, so the legacy iterator_category is input.
+  // The iterator remains multi-pass: iterator_concept reports forward (or bidirectional), so
+  // std::forward_iterator<> is satisfied and range algorithms may traverse the view more than once.
+  // This is the same arrangement as std::ranges::transform_view with a function that returns by
+  // value. Code that dispatches on std::iterator_traits<>::iterator_category will see a
+  // single-pass iterator.
+  using iterator_category = std::input_iterator_tag;
+  using iterator_concept = std::conditional_t<details::reversible<View, Buffering>, std::bidirectional_iterator_tag,
+                                              std::forward_iterator_tag>;
+
+  using value_type = ToEncoding;
+  using difference_type = std::ranges::range_difference_t<View>;
+
+  iterator () requires std::default_initializable<std::ranges::iterator_t<View>> = default;
+  constexpr iterator (transcode_view const& parent, std::ranges::iterator_t<View> current)
+      : current_{current}, parent_{&parent}, state_{current} {
+    assert (state_.empty ());
+    // Prime the input state so that a dereference of the iterator will yield the first of the
+    // output code-units.
+    current_ = state_.fill (parent_->base_, current_);
+  }
+
+  /// \returns True if the input encoding was well-formed.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return state_.well_formed (); }
+
+  constexpr std::ranges::iterator_t<View> const& base () const& noexcept { return current_; }
+  constexpr std::ranges::iterator_t<View> base () && { return std::move (current_); }
+
+  constexpr value_type operator* () const { return state_.front (); }
+
+  constexpr iterator& operator++ () {
+    state_.advance ();
+    if (state_.empty ()) {
+      // We've exhausted the stashed output code units. Refill the buffer and reset.
+      current_ = state_.fill (parent_->base_, current_);
+    }
+    return *this;
+  }
+  constexpr void operator++ (int) { ++*this; }
+  constexpr iterator operator++ (int) requires std::ranges::forward_range<View> {
+    auto result = *this;
+    ++*this;
+    return result;
+  }
+
+  /// Steps back to the previous output code-unit. If the current code-point's output is
+  /// exhausted, the input is resynchronized on the start of the preceding code-point and that
+  /// code-point is transcoded afresh. Reverse iteration over ill-formed input may therefore
+  /// not produce exactly the reverse of forward iteration, and well_formed() reflects only the
+  /// input that has been transcoded since the most recent resynchronization.
+  constexpr iterator& operator-- () requires details::reversible<View, Buffering> {
+    if (!state_.retreat ()) {
+      current_ = state_.fill_previous (parent_->base_, current_);
+    }
+    return *this;
+  }
+  constexpr iterator operator-- (int) requires details::reversible<View, Buffering> {
+    auto result = *this;
+    --*this;
+    return result;
+  }
+
+  friend constexpr bool operator== (iterator const& x, iterator const& y)
+    requires std::equality_comparable<std::ranges::iterator_t<View>>
+  {
+    return x.current_ == y.current_ && x.state_.offset () == y.state_.offset ();
+  }
+
+  friend constexpr std::ranges::range_rvalue_reference_t<View> iter_move (iterator const& it) noexcept (
+      noexcept (std::ranges::iter_move (it.current_))) {
+    return std::ranges::iter_move (it.current_);
+  }
+
+  friend constexpr void iter_swap (iterator const& x,
+                                   iterator const& y) noexcept (noexcept (std::ranges::iter_swap (x.current_,
+                                                                                                  y.current_)))
+    requires std::indirectly_swappable<std::ranges::iterator_t<View>>
+  {
+    return std::ranges::iter_swap (x.current_, y.current_);
+  }
+
+private:
+  std::ranges::iterator_t<View> current_{};
+  transcode_view const* parent_ = nullptr;
+
+  class state {
+  public:
+    constexpr explicit state (std::ranges::iterator_t<View> const& it) {
+      if constexpr (!count_consumed) {
+        next_ = it;
+      }
+    }
+    constexpr state () : state{std::ranges::iterator_t<View>{}} {}
+
+    [[nodiscard]] constexpr bool empty () const noexcept { return first_ == last_; }
+    [[nodiscard]] constexpr bool well_formed () const noexcept { return transcoder_.well_formed (); }
+    /// \returns The number of code-units that precede front() in the out_ container.
+    [[nodiscard]] constexpr std::size_t offset () const noexcept { return first_; }
+    [[nodiscard]] constexpr auto& front () const noexcept { return out_[first_]; }
+    constexpr void advance () noexcept { ++first_; }
+    /// Steps back to the preceding code-unit in the out_ container.
+    ///
+    /// \returns False if there is no preceding code-unit in the container.
+    constexpr bool retreat () noexcept {
+      if (first_ == 0U) {
+        return false;
+      }
+      --first_;
+      return true;
+    }
+
+    /// Consumes enough code-units from the base iterator to form a single code-point (or, if
+    /// buffered, to fill as much of the buffer as possible). The resulting code-units in the output
+    /// encoding can be sequentially accessed using the front() and advance() methods.
+    ///
+    /// \param base  The base view.
+    /// \param current  The position of the first code-unit of the current code-point.
+    /// \returns The updated base iterator.
+    constexpr std::ranges::iterator_t<View> fill (View const& base, std::ranges::iterator_t<View> const& current);
+    /// Transcodes the code-point which precedes \p current leaving the state's front() referring
+    /// to the last of the resulting code-units.
+    ///
+    /// \param base  The base view.
+    /// \param current  The position of the first code-unit of the current code-point.
+    /// \returns The position of the first code-unit of the preceding code-point.
+    constexpr std::ranges::iterator_t<View> fill_previous (View const& base,
+                                                           std::ranges::iterator_t<View> const& current);
+
+  private:
+    static constexpr auto out_size = details::buffer_size<Buffering, ToEncoding>::value;
+    using out_type = std::array<ToEncoding, out_size>;
+    /// The smallest type which can hold an index into out_.
+    using index_type = std::conditional_t<
+        (out_size <= std::numeric_limits<std::uint_least8_t>::max ()), std::uint_least8_t,
+        std::conditional_t<(out_size <= std::numeric_limits<std::uint_least16_t>::max ()), std::uint_least16_t,
+                           std::size_t>>;
+    /// Unbuffered output is produced from no more than a few code-units so, rather than holding a
+    /// second base iterator, the end of the consumed input is recorded as the number of code-units
+    /// that follow the iterator's current position.
+    static constexpr bool count_consumed = std::is_same_v<Buffering, unbuffered>;
+    using next_type = std::conditional_t<count_consumed, std::uint_least8_t, std::ranges::iterator_t<View>>;
+
+    /// \returns The position of the first code-unit which has not been passed to the transcoder.
+    constexpr std::ranges::iterator_t<View> next (std::ranges::iterator_t<View> const& current) const {
+      if constexpr (count_consumed) {
+        return std::ranges::next (current, next_);
+      } else {
+        return next_;
+      }
+    }
+
+    transcoder<FromEncoding, ToEncoding> transcoder_;
+    /// The container into which the transcoder's output will be written.
+    out_type out_{};
+    /// The valid range of code units in the out_ container, [first_, last_). Determines the
+    /// code-units to be produced when the view is dereferenced. These are indices rather than
+    /// iterators so that copying the state does not leave them referring to the original's
+    /// container.
+    index_type first_ = 0;
+    index_type last_ = 0;
+    next_type next_{};
+    /// True once the whole input has been consumed and transcoder_.end_cp() called.
+    bool ended_ = false;
+  };
+  mutable state state_{};
+};
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View,
+          typename Buffering>
+  requires std::ranges::view<View>
+constexpr std::ranges::iterator_t<View>
+transcode_view<FromEncoding, ToEncoding, View, Buffering>::iterator::state::fill (
+    View const& base, std::ranges::iterator_t<View> const& current) {
+  auto next = this->next (current);
+  auto result = next;
+  assert (this->empty () && "out_ was not empty when fill called");
+
+  auto it = out_.begin ();
+  auto const input_end = std::ranges::end (base);
+  if constexpr (count_consumed) {
+    // Loop until we've produced a code-point's worth of code-units in the out
+    // container or we've run out of input.
+    next_ = 0;
+    while (it == out_.begin () && next != input_end) {
+      it = transcoder_ (*next, it);
+      ++next;
+      ++next_;
+    }
+  } else if constexpr (details::bulk_transcodable<FromEncoding, View> && std::is_same_v<FromEncoding, ToEncoding>) {
+    // The input is contiguous and needs no conversion. A block which is well formed and ends at a
+    // code-point boundary is checked (ASCII a word at a time) and then copied unchanged. Anything
+    // else is passed through the transcoder in the same way as the general contiguous case.
+    constexpr auto headroom = static_cast<std::ptrdiff_t> (details::max_output_per_unit<ToEncoding>);
+    while (next != input_end) {
+      auto const* const first = std::to_address (next);
+      auto const* const input_last = first + (input_end - next);
+      auto const* last = first + std::min (input_last - first, out_.end () - it);
+      for (auto ctr = longest_sequence_v<FromEncoding> - 1U;
+           ctr > 0U && last != first && last != input_last && !is_code_point_start (*last); --ctr) {
+        --last;
+      }
+      transcoder<FromEncoding, char32_t> probe;
+      if (last != first && !transcoder_.partial () && icubaby::details::validate (probe, first, last) &&
+          !probe.partial ()) {
+        it = std::copy (first, last, it);
+        next += last - first;
+        continue;
+      }
+      auto const size = std::min (input_end - next, (out_.end () - it) / headroom);
+      if (size == 0) {
+        break;
+      }
+      it = icubaby::transcode (transcoder_, first, first + size, it);
+      next += size;
+    }
+    next_ = next;
+  } else if constexpr (details::bulk_transcodable<FromEncoding, View>) {
+    // The input is contiguous so pass blocks of code-units directly to the bulk transcoder
+    // (which can take its ASCII fast path). Each block is no larger than the out container is
+    // guaranteed to accommodate.
+    constexpr auto headroom = static_cast<std::ptrdiff_t> (details::max_output_per_unit<ToEncoding>);
+    for (;;) {
+      auto const size = std::min (input_end - next, (out_.end () - it) / headroom);
+      if (size == 0) {
+        break;
+      }
+      auto const* const first = std::to_address (next);
+      it = icubaby::transcode (transcoder_, first, first + size, it);
+      next += size;
+    }
+    next_ = next;
+  } else {
+    // Loop until the out container might not have room for the output from
+    // another code-unit or we've run out of input.
+    constexpr auto headroom = static_cast<std::ptrdiff_t> (details::max_output_per_unit<ToEncoding>);
+    while (next != input_end && out_.end () - it >= headroom) {
+      it = transcoder_ (*next, it);
+      ++next;
+    }
+    next_ = next;
+  }
+  if (next == input_end && !ended_) {
+    // We've consumed the entire input so tell the transcoder and get any final output. This
+    // belongs with the output from the last code-unit: there is always room for it because the
+    // two together produce no more than two code-points. Once the input is exhausted, fill() may
+    // be called again (when the final output has been consumed) but end_cp() must not be.
+    it = transcoder_.end_cp (it);
+    ended_ = true;
+  }
+  assert (it >= out_.begin () && it <= out_.end ());
+  first_ = 0;
+  last_ = static_cast<index_type> (it - out_.begin ());
+  return result;
+}
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View,
+          typename Buffering>
+  requires std::ranges::view<View>
+constexpr std::ranges::iterator_t<View>
+transcode_view<FromEncoding, ToEncoding, View, Buffering>::iterator::state::fill_previous (
+    View const& base, std::ranges::iterator_t<View> const& current) {
+  auto pos = details::previous_code_point_start<FromEncoding> (std::ranges::begin (base), current);
+  transcoder_ = transcoder<FromEncoding, ToEncoding>{};
+  ended_ = false;
+  // The code-units between pos and current may, if ill-formed, produce more than one code-point.
+  // Transcode them a code-point at a time (so that out_ cannot overflow) and keep the last.
+  auto result = pos;
+  auto it = out_.begin ();
+  while (pos != current) {
+    result = pos;
+    it = out_.begin ();
+    next_ = 0;
+    while (it == out_.begin () && pos != current) {
+      it = transcoder_ (*pos, it);
+      ++pos;
+      ++next_;
+    }
+  }
+  it = transcoder_.end_cp (it);
+  assert (it > out_.begin () && it <= out_.end ());
+  last_ = static_cast<index_type> (it - out_.begin ());
+  first_ = static_cast<index_type> (last_ - 1U);
+  return result;
+}
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View,
+          typename Buffering>
+  requires std::ranges::view<View>
+class transcode_view<FromEncoding, ToEncoding, View, Buffering>::sentinel {
+public:
+  sentinel () = default;
+  constexpr explicit sentinel (transcode_view const& parent) : end_{std::ranges::end (parent.base_)} {}
+  constexpr std::ranges::sentinel_t<View> base () const { return end_; }
+  friend constexpr bool operator== (iterator const& x, sentinel const& y) { return x.base () == y.end_; }
+
+private:
+  std::ranges::sentinel_t<View> end_{};
+};
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View,
+          typename Buffering>
+  requires std::ranges::view<View>
+class transcode_view<FromEncoding, ToEncoding, View, Buffering>::input_state {
+public:
+  constexpr void start (std::ranges::iterator_t<View> first, std::ranges::sentinel_t<View> last) {
+    next_.emplace (std::move (first));
+    last_input_.emplace (std::move (last));
+    this->fill ();
+  }
+
+  [[nodiscard]] constexpr bool empty () const noexcept { return first_ == last_; }
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return transcoder_.well_formed (); }
+  [[nodiscard]] constexpr ToEncoding front () const noexcept { return out_[first_]; }
+  constexpr void advance () {
+    if (++first_ == last_) {
+      this->fill ();
+    }
+  }
+
+private:
+  /// An unbuffered view reads a code-unit at a time and yields each code-point as soon as it is
+  /// complete: nothing is read from the base range ahead of the output that depends on it, which
+  /// matters for interactive sources. A buffered view reads blocks of code-units and passes them to
+  /// the bulk transcoder.
+  static constexpr bool streaming = std::is_same_v<Buffering, unbuffered>;
+  /// The number of code-units read from the base range at a time by a buffered view.
+  static constexpr std::size_t in_size = streaming ? 0U : details::buffer_size<Buffering, ToEncoding>::value;
+  /// The out_ container must hold the output from a full block of input plus that which may be
+  /// held back from the previous block and the output of end_cp().
+  static constexpr std::size_t out_size =
+      max_transcoded_size<FromEncoding, ToEncoding> (in_size) + details::max_output_per_unit<ToEncoding>;
+
+  /// Reads code-units from the base range and transcodes them until there is output or the input
+  /// is exhausted.
+  constexpr void fill () {
+    first_ = 0;
+    last_ = 0;
+    if constexpr (streaming) {
+      auto it = out_.begin ();
+      // Don't test for the end of the input once there is output: doing so may wait for input.
+      while (it == out_.begin () && !done_) {
+        if (*next_ == *last_input_) {
+          it = transcoder_.end_cp (it);
+          done_ = true;
+        } else {
+          it = transcoder_ (static_cast<FromEncoding> (**next_), it);
+          ++*next_;
+        }
+      }
+      last_ = static_cast<std::size_t> (it - out_.begin ());
+    } else {
+      while (last_ == 0 && !done_) {
+        auto n = std::size_t{0};
+        for (; n < in_size && *next_ != *last_input_; ++n, ++*next_) {
+          in_[n] = static_cast<FromEncoding> (**next_);
+        }
+        auto it = icubaby::transcode (transcoder_, in_.data (), in_.data () + n, out_.begin ());
+        if (n < in_size) {
+          it = transcoder_.end_cp (it);
+          done_ = true;
+        }
+        assert (it >= out_.begin () && it <= out_.end ());
+        last_ = static_cast<std::size_t> (it - out_.begin ());
+      }
+    }
+  }
+
+  std::optional<std::ranges::iterator_t<View>> next_;
+  std::optional<std::ranges::sentinel_t<View>> last_input_;
+  transcoder<FromEncoding, ToEncoding> transcoder_;
+  bool done_ = false;
+  std::size_t first_ = 0;
+  std::size_t last_ = 0;
+  std::array<FromEncoding, in_size> in_{};
+  std::array<ToEncoding, out_size> out_{};
+};
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, std::ranges::input_range View,
+          typename Buffering>
+  requires std::ranges::view<View>
+class transcode_view<FromEncoding, ToEncoding, View, Buffering>::input_iterator {
+public:
+  using iterator_concept = std::input_iterator_tag;
+  using value_type = ToEncoding;
+  using difference_type = std::ptrdiff_t;
+
+  constexpr explicit input_iterator (transcode_view& parent) noexcept : parent_{&parent} {}
+  input_iterator (input_iterator const&) = delete;
+  input_iterator (input_iterator&&) noexcept = default;
+  ~input_iterator () noexcept = default;
+  input_iterator& operator= (input_iterator const&) = delete;
+  input_iterator& operator= (input_iterator&&) noexcept = default;
+
+  /// \returns True if the input encoding was well-formed.
+  [[nodiscard]] constexpr bool well_formed () const noexcept { return parent_->input_.well_formed (); }
+
+  constexpr value_type operator* () const { return parent_->input_.front (); }
+  constexpr input_iterator& operator++ () {
+    parent_->input_.advance ();
+    return *this;
+  }
+  constexpr void operator++ (int) { ++*this; }
+
+  friend constexpr bool operator== (input_iterator const& x, std::default_sentinel_t /*unused*/) {
+    return x.at_end ();
+  }
+
+private:
+  [[nodiscard]] constexpr bool at_end () const noexcept { return parent_->input_.empty (); }
+
+  transcode_view* parent_;
+};
+
+namespace views::transcode {
+
+/// Determines whether \p T is a transcode_view whose output is code units of type \p Encoding and
+/// which uses the buffering policy \p Buffering.
+template <typename T, typename Encoding, typename Buffering> struct is_transcode_view_to : std::false_type {};
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, typename View, typename Buffering>
+struct is_transcode_view_to<transcode_view<FromEncoding, ToEncoding, View, Buffering>, ToEncoding, Buffering>
+    : std::true_type {
+  using from_encoding = FromEncoding;
+  using base_view = View;
+};
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, typename Buffering = unbuffered>
+class transcode_range_adaptor {
+public:
+  template <std::ranges::viewable_range Range> constexpr auto operator() (Range&& range) const {
+    using inner = is_transcode_view_to<std::remove_cvref_t<Range>, FromEncoding, Buffering>;
+    if constexpr (std::is_same_v<Buffering, unchecked>) {
+      static_assert (std::is_same_v<FromEncoding, ToEncoding>, "unchecked requires that the encodings are the same");
+      return std::views::all (std::forward<Range> (range));
+    } else if constexpr (inner::value) {
+      // The range is itself the output of a transcode_view with the same buffering policy. Any
+      // ill-formed input to that view has already become U+FFFD REPLACEMENT CHARACTER so its output
+      // passes through a second transcoder unchanged. Collapse the two views into one which
+      // transcodes directly from the inner view's input encoding and so avoids the intermediate
+      // encoding altogether. The code units produced are identical, but note that the fused view's
+      // iterators report well_formed() for the original input: a chain's outer iterators would see
+      // only the inner view's output and always report true.
+      return transcode_view<typename inner::from_encoding, ToEncoding, typename inner::base_view, Buffering>{
+          std::forward<Range> (range).base ()};
+    } else {
+      return transcode_view<FromEncoding, ToEncoding, std::ranges::views::all_t<Range>, Buffering>{
+          std::forward<Range> (range)};
+    }
+  }
+};
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, typename Buffering,
+          std::ranges::viewable_range Range>
+constexpr auto operator| (Range&& r, transcode_range_adaptor<FromEncoding, ToEncoding, Buffering> const& adaptor) {
+  return adaptor (std::forward<Range> (r));
+}
+
+}  // end namespace views::transcode
+
+template <unicode_char_type FromEncoding, unicode_char_type ToEncoding, typename Buffering = unbuffered>
+inline constexpr auto transcode = views::transcode::transcode_range_adaptor<FromEncoding, ToEncoding, Buffering>{};
 
 }  // end namespace ranges
 
 #endif  // ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
 
+#if ICUBABY_HAVE_COROUTINES && ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+#if ICUBABY_HAVE_STD_GENERATOR
+template <typename T> using generator = std::generator<T>;
+#else
+/// A minimal coroutine generator. Values passed to co_yield are produced, one at
+/// a time, by the generator's input iterator. The coroutine is suspended after
+/// each value and resumed when the iterator is incremented.
+template <typename T> class generator : public std::ranges::view_interface<generator<T>> {
+public:
+  class promise_type;
+  class iterator;
+
+  generator (generator const&) = delete;
+  generator (generator&& other) noexcept : handle_{std::exchange (other.handle_, nullptr)} {}
+  ~generator () noexcept {
+    if (handle_) {
+      handle_.destroy ();
+    }
+  }
+
+  generator& operator= (generator const&) = delete;
+  generator& operator= (generator&& other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy ();
+      }
+      handle_ = std::exchange (other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  /// Resumes the coroutine to produce the first value.
+  iterator begin () {
+    assert (handle_ && "begin() may only be called once");
+    handle_.resume ();
+    return iterator{handle_};
+  }
+  [[nodiscard]] constexpr std::default_sentinel_t end () const noexcept { return std::default_sentinel; }
+
+private:
+  using handle_type = std::coroutine_handle<promise_type>;
+  explicit generator (handle_type handle) noexcept : handle_{handle} {}
+  handle_type handle_;
+};
+
+template <typename T> class generator<T>::promise_type {
+public:
+  generator get_return_object () noexcept { return generator{handle_type::from_promise (*this)}; }
+  static std::suspend_always initial_suspend () noexcept { return {}; }
+  static std::suspend_always final_suspend () noexcept { return {}; }
+  std::suspend_always yield_value (T value) noexcept (std::is_nothrow_move_assignable_v<T>) {
+    value_ = std::move (value);
+    return {};
+  }
+  static void return_void () noexcept {}
+  static void unhandled_exception () { throw; }
+  /// Generators may not use co_await.
+  template <typename U> std::suspend_never await_transform (U&&) = delete;
+
+  [[nodiscard]] constexpr T const& value () const noexcept { return value_; }
+
+private:
+  T value_{};
+};
+
+template <typename T> class generator<T>::iterator {
+public:
+  using iterator_concept = std::input_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+
+  iterator () noexcept = default;
+  explicit iterator (handle_type handle) noexcept : handle_{handle} {}
+
+  T const& operator* () const noexcept { return handle_.promise ().value (); }
+  iterator& operator++ () {
+    handle_.resume ();
+    return *this;
+  }
+  void operator++ (int) { ++*this; }
+
+  friend bool operator== (iterator const& x, std::default_sentinel_t) noexcept { return x.handle_.done (); }
+
+private:
+  handle_type handle_ = nullptr;
+};
+#endif  // ICUBABY_HAVE_STD_GENERATOR
+
+/// The default number of code units in each of the batches produced by
+/// generate().
+inline constexpr std::size_t generate_batch_size = 256;
+
+namespace details {
+
+template <typename Transcoder, std::size_t BatchSize, std::ranges::input_range View>
+generator<std::span<typename Transcoder::output_type const>> generate_batches (Transcoder* external, View view) {
+  using output_type = typename Transcoder::output_type;
+  constexpr auto longest = longest_sequence_v<output_type>;
+  // A single input code unit can produce up to two code points of output (for
+  // example, U+FFFD REPLACEMENT CHARACTER followed by the code unit itself)
+  // so the buffer has space for that beyond the batch size.
+  std::array<output_type, BatchSize + 2 * longest> buffer;
+  Transcoder local;
+  auto& t = external != nullptr ? *external : local;
+
+  auto* const first = buffer.data ();
+  auto* out = first;
+  auto full = [&out, first] { return static_cast<std::size_t> (out - first) >= BatchSize; };
+  // Moves the code units beyond the end of a yielded batch to the front of the
+  // buffer where they become the start of the next batch.
+  auto shift = [&out, first] { out = std::copy (first + BatchSize, out, first); };
+  if constexpr (std::ranges::contiguous_range<View> && std::ranges::sized_range<View>) {
+    // Pass as many code units to transcode() as will fit in the remaining
+    // space in the buffer.
+    auto const* in = std::ranges::data (view);
+    auto const* const end = in + std::ranges::size (view);
+    while (in != end) {
+      auto const room = static_cast<std::size_t> (first + BatchSize - out);
+      auto const n = std::min (std::max (room / longest, std::size_t{1}), static_cast<std::size_t> (end - in));
+      out = transcode (t, in, in + n, out);
+      in += n;
+      while (full ()) {
+        co_yield std::span<output_type const>{first, BatchSize};
+        shift ();
+      }
+    }
+  } else {
+    for (auto&& c : view) {
+      out = t (static_cast<typename Transcoder::input_type> (c), out);
+      while (full ()) {
+        co_yield std::span<output_type const>{first, BatchSize};
+        shift ();
+      }
+    }
+  }
+  out = t.end_cp (out);
+  while (full ()) {
+    co_yield std::span<output_type const>{first, BatchSize};
+    shift ();
+  }
+  if (out != first) {
+    co_yield std::span<output_type const>{first, out};
+  }
+}
+
+}  // end namespace details
+
+/// Returns a generator which lazily transcodes the code units of \p range
+/// from encoding \p From to \p To. Rather than producing one code unit at a
+/// time, each value yielded is a span of exactly \p BatchSize output code units
+/// except for the last which may be shorter.
+/// The coroutine is suspended after each batch so that the input is consumed
+/// only as the consumer requests more output. The span is valid until the
+/// generator's iterator is next incremented.
+///
+/// \tparam From  The encoding of the input code units.
+/// \tparam To  The encoding of the output code units.
+/// \tparam BatchSize  The number of code units yielded by each step other than
+///   the last.
+/// \param range  The range of input code units.
+/// \returns  A generator producing spans of output code units.
+template <unicode_char_type From, unicode_char_type To, std::size_t BatchSize = generate_batch_size,
+          std::ranges::viewable_range Range>
+  requires std::ranges::input_range<Range> && (BatchSize > 0)
+generator<std::span<To const>> generate (Range&& range) {
+  return details::generate_batches<transcoder<From, To>, BatchSize> (nullptr,
+                                                                      std::views::all (std::forward<Range> (range)));
+}
+
+/// Returns a generator which lazily transcodes the code units of \p range
+/// using transcoder \p t. The caller may query the transcoder (for example,
+/// with well_formed()) once the generator is exhausted.
+///
+/// \tparam BatchSize  The number of code units yielded by each step other than
+///   the last.
+/// \param t  The transcoder to be used. It must outlive the generator.
+/// \param range  The range of input code units.
+/// \returns  A generator producing spans of output code units.
+template <std::size_t BatchSize = generate_batch_size, typename Transcoder, std::ranges::viewable_range Range>
+  requires is_transcoder<Transcoder> && std::ranges::input_range<Range> && (BatchSize > 0)
+generator<std::span<typename Transcoder::output_type const>> generate (Transcoder& t, Range&& range) {
+  return details::generate_batches<Transcoder, BatchSize> (&t, std::views::all (std::forward<Range> (range)));
+}
+
+#endif  // ICUBABY_HAVE_COROUTINES && ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
 }  // end namespace icubaby
 
 #ifdef ICUBABY_INSIDE_NS
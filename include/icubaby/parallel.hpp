@@ -0,0 +1,484 @@
+//*  _         _          _          *
+//* (_)__ _  _| |__  __ _| |__ _  _  *
+//* | / _| || | '_ \/ _` | '_ \ || | *
+//* |_\__|\_,_|_.__/\__,_|_.__/\_, | *
+//*                            |__/  *
+// Home page:
+// https://paulhuggett.github.io/icubaby/
+//
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+/// \file   parallel.hpp
+/// \brief  Multi-threaded algorithms for transcoding and examining large
+///   buffers. Unlike icubaby.hpp, this header depends on the standard library's
+///   thread support.
+
+#ifndef ICUBABY_PARALLEL_HPP
+#define ICUBABY_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "icubaby/icubaby.hpp"
+
+#ifdef ICUBABY_INSIDE_NS
+namespace ICUBABY_INSIDE_NS {
+#endif
+
+namespace icubaby {
+
+/// An execution policy which requests that an algorithm's work be divided
+/// between multiple threads.
+struct parallel_policy {
+  /// The maximum number of threads to be used. Zero selects the value of
+  /// std::thread::hardware_concurrency().
+  unsigned threads = 0;
+  /// The minimum number of code units to be processed by each thread. Inputs
+  /// smaller than twice this value are processed on the calling thread.
+  std::size_t min_chunk_size = std::size_t{1} << 16U;
+};
+
+/// The default parallel execution policy.
+inline constexpr parallel_policy par{};
+
+/// An independent unit of work for transcode_jobs(): a range of input code
+/// units and, once the job is complete, the result of transcoding them.
+template <typename From, typename To> struct transcode_job {
+  /// The start of the range of code units to be transcoded.
+  From const* first = nullptr;
+  /// The end of the range of code units to be transcoded.
+  From const* last = nullptr;
+  /// The transcoded output.
+  std::vector<To> output;
+  /// True if the input was well formed.
+  bool well_formed = true;
+};
+
+/// The result of a parallel transcode() operation.
+template <typename OutputIterator> struct transcode_result {
+  /// Iterator one past the last element assigned.
+  OutputIterator out;
+  /// True if the input was well formed.
+  bool well_formed;
+};
+
+namespace details {
+
+/// Owns a collection of threads which are joined on destruction.
+class thread_group {
+public:
+  thread_group () noexcept = default;
+  thread_group (thread_group const&) = delete;
+  thread_group (thread_group&&) noexcept = delete;
+  ~thread_group () noexcept {
+    for (auto& thread : threads_) {
+      if (thread.joinable ()) {
+        thread.join ();
+      }
+    }
+  }
+
+  thread_group& operator= (thread_group const&) = delete;
+  thread_group& operator= (thread_group&&) noexcept = delete;
+
+  void reserve (std::size_t n) { threads_.reserve (n); }
+  template <typename Function, typename... Args> void spawn (Function&& f, Args&&... args) {
+    threads_.emplace_back (std::forward<Function> (f), std::forward<Args> (args)...);
+  }
+
+private:
+  std::vector<std::thread> threads_;
+};
+
+/// Calls \p f(i) for each i in [0, n) with each call made on its own thread.
+/// The call f(0) is made on the calling thread. Returns once all of the calls
+/// have completed. If any of the calls throws, the exception is captured and
+/// rethrown on the calling thread once all of the threads have been joined.
+template <typename Function> void parallel_for (std::size_t n, Function const& f) {
+  std::vector<std::exception_ptr> errors (n);
+  auto const guarded = [&f, &errors] (std::size_t i) {
+    try {
+      f (i);
+    } catch (...) {
+      errors[i] = std::current_exception ();
+    }
+  };
+  {
+    thread_group group;
+    group.reserve (n);
+    for (auto i = std::size_t{1}; i < n; ++i) {
+      group.spawn (guarded, i);
+    }
+    if (n > 0) {
+      guarded (std::size_t{0});
+    }
+  }
+  for (auto const& error : errors) {
+    if (error) {
+      std::rethrow_exception (error);
+    }
+  }
+}
+
+/// Returns the number of threads requested by \p policy.
+inline unsigned thread_count (parallel_policy const& policy) noexcept {
+  return policy.threads != 0 ? policy.threads : std::max (std::thread::hardware_concurrency (), 1U);
+}
+
+/// Divides the code units [first, last) into chunks which may be transcoded
+/// independently. The result holds the start of each chunk followed by \p last.
+template <typename From>
+std::vector<From const*> chunk_boundaries (parallel_policy const& policy, From const* first, From const* last) {
+  auto const size = static_cast<std::size_t> (last - first);
+  auto const parts = std::clamp (size / std::max (policy.min_chunk_size, std::size_t{1}), std::size_t{1},
+                                 std::size_t{thread_count (policy)});
+  std::vector<From const*> result;
+  result.reserve (parts + 1U);
+  result.push_back (first);
+  split (first, last, parts, [&result] (From const* pos) { result.push_back (pos); });
+  return result;
+}
+
+/// A collection of task queues, one per worker thread. A worker takes tasks
+/// from the front of its own queue and, once that is empty, steals from the
+/// back of the others'. If the tasks are pushed largest first, each worker
+/// therefore starts with its largest task and a thief takes the smallest that
+/// remains, so a steal late in the run does not hold up the others for long.
+/// All tasks must be pushed before the workers start.
+template <typename Task> class work_queues {
+public:
+  explicit work_queues (std::size_t workers) : queues_ (workers) {}
+
+  /// Adds \p task to the queue belonging to \p worker.
+  void push (std::size_t worker, Task const& task) {
+    auto& q = queues_[worker];
+    std::lock_guard<std::mutex> const lock{q.mut};
+    q.tasks.push_back (task);
+  }
+  /// Removes a task for \p worker to run. Returns std::nullopt once every
+  /// queue is empty.
+  std::optional<Task> pop (std::size_t worker) {
+    auto const workers = queues_.size ();
+    for (auto i = std::size_t{0}; i < workers; ++i) {
+      auto& q = queues_[(worker + i) % workers];
+      std::lock_guard<std::mutex> const lock{q.mut};
+      if (!q.tasks.empty ()) {
+        Task result;
+        if (i == 0) {
+          result = q.tasks.front ();
+          q.tasks.pop_front ();
+        } else {
+          result = q.tasks.back ();
+          q.tasks.pop_back ();
+        }
+        return result;
+      }
+    }
+    return std::nullopt;
+  }
+
+private:
+  struct queue {
+    std::mutex mut;
+    std::deque<Task> tasks;
+  };
+  std::vector<queue> queues_;
+};
+
+}  // end namespace details
+
+/// Transcodes the code units [first, last) from encoding \p From to \p To using
+/// multiple threads. The input is divided into chunks at positions where
+/// transcoding can restart without changing the result. The chunks are
+/// processed concurrently in two passes. The first pass transcodes the first
+/// chunk directly to \p dest and counts the output of each of the others. A
+/// prefix sum of those counts gives the position of each chunk's output, and
+/// the second pass transcodes the remaining chunks directly to those
+/// positions. No intermediate buffers are needed. The output is identical to
+/// that produced by a single transcoder (including the replacement of
+/// ill-formed input with U+FFFD REPLACEMENT CHARACTER).
+///
+/// \tparam From  The encoding of the input code units.
+/// \tparam To  The encoding of the output code units.
+/// \param policy  Controls the number of threads used.
+/// \param first  The start of the range of code units to be transcoded.
+/// \param last  The end of the range of code units to be transcoded.
+/// \param dest  A random access iterator to which the output is written.
+/// \returns  Iterator one past the last element assigned and whether the
+///   input was well formed.
+template <typename From, typename To, typename RandomAccessIterator>
+ICUBABY_REQUIRES ((unicode_char_type<From> && unicode_char_type<To> &&
+                   std::random_access_iterator<RandomAccessIterator> &&
+                   std::output_iterator<RandomAccessIterator, To>))
+transcode_result<RandomAccessIterator> transcode (parallel_policy const& policy, From const* first, From const* last,
+                                                  RandomAccessIterator dest) {
+  auto const boundaries = details::chunk_boundaries (policy, first, last);
+  auto const chunks = boundaries.size () - 1U;
+  if (chunks == 1U) {
+    transcoder<From, To> t;
+    dest = t.end_cp (transcode (t, first, last, dest));
+    return {dest, t.well_formed ()};
+  }
+
+  // The first pass writes the first chunk's output (which always starts at dest) and counts the
+  // output of the others.
+  std::vector<std::size_t> offsets (chunks);
+  std::vector<char> well_formed (chunks);
+  details::parallel_for (chunks, [&] (std::size_t chunk) {
+    transcoder<From, To> t;
+    auto const* const chunk_first = boundaries[chunk];
+    auto const* const chunk_last = boundaries[chunk + 1U];
+    if (chunk == 0U) {
+      auto const out = transcode (t, chunk_first, chunk_last, dest);
+      offsets[chunk] = static_cast<std::size_t> (std::distance (dest, out));
+    } else {
+      auto out = transcode (t, chunk_first, chunk_last, details::counting_iterator{});
+      if (chunk == chunks - 1U) {
+        out = t.end_cp (out);
+      }
+      offsets[chunk] = out.count ();
+    }
+    assert ((chunk == chunks - 1U || !t.partial ()) && "chunk did not end at a code point boundary");
+    well_formed[chunk] = t.well_formed ();
+  });
+  auto const total = std::accumulate (offsets.begin (), offsets.end (), std::size_t{0});
+  std::exclusive_scan (offsets.begin (), offsets.end (), offsets.begin (), std::size_t{0});
+
+  // The second pass transcodes the remaining chunks to their final positions.
+  details::parallel_for (chunks - 1U, [&] (std::size_t index) {
+    auto const chunk = index + 1U;
+    transcoder<From, To> t;
+    auto out = transcode (t, boundaries[chunk], boundaries[chunk + 1U],
+                          std::next (dest, static_cast<std::ptrdiff_t> (offsets[chunk])));
+    if (chunk == chunks - 1U) {
+      t.end_cp (out);
+    }
+  });
+  return {std::next (dest, static_cast<std::ptrdiff_t> (total)),
+          std::all_of (well_formed.begin (), well_formed.end (), [] (char wf) { return wf != 0; })};
+}
+
+/// Returns the number of code points in the sequence [first, last). The input
+/// is divided between multiple threads and the per-thread counts are summed.
+/// As with the single-threaded length(), the input must be well formed for the
+/// result to be accurate.
+///
+/// \param policy  Controls the number of threads used.
+/// \param first  The start of the range of code units to examine.
+/// \param last  The end of the range of code units to examine.
+/// \returns  The number of code points.
+template <typename T>
+ICUBABY_REQUIRES ((unicode_char_type<T>))
+std::ptrdiff_t length (parallel_policy const& policy, T const* first, T const* last) {
+  // Whether a code unit starts a code point does not depend on its neighbors
+  // so the input can be divided anywhere.
+  auto const size = static_cast<std::size_t> (last - first);
+  auto const chunks = std::clamp (size / std::max (policy.min_chunk_size, std::size_t{1}), std::size_t{1},
+                                  std::size_t{details::thread_count (policy)});
+  std::vector<std::ptrdiff_t> counts (chunks);
+  details::parallel_for (chunks, [&] (std::size_t chunk) {
+    counts[chunk] =
+        details::count_code_point_starts (first + size * chunk / chunks, first + size * (chunk + 1U) / chunks);
+  });
+  return std::accumulate (counts.begin (), counts.end (), std::ptrdiff_t{0});
+}
+
+/// Returns true if the code units [first, last) are a well formed sequence in
+/// the encoding given by their type. The input is divided between multiple
+/// threads at positions where validation can restart without changing the
+/// result. All of the threads stop as soon as one of them finds an error.
+///
+/// \param policy  Controls the number of threads used.
+/// \param first  The start of the range of code units to examine.
+/// \param last  The end of the range of code units to examine.
+/// \returns  True if the input is well formed.
+template <typename T>
+ICUBABY_REQUIRES ((unicode_char_type<T>))
+bool is_well_formed (parallel_policy const& policy, T const* first, T const* last) {
+  auto const boundaries = details::chunk_boundaries (policy, first, last);
+  auto const chunks = boundaries.size () - 1U;
+  std::atomic<bool> well_formed{true};
+  details::parallel_for (chunks, [&] (std::size_t chunk) {
+    // Work through the chunk in blocks so that we notice quickly if another
+    // thread finds an error.
+    constexpr auto block_size = std::ptrdiff_t{1} << 14U;
+    transcoder<T, char32_t> t;
+    auto const* const chunk_last = boundaries[chunk + 1U];
+    for (auto const* pos = boundaries[chunk]; pos != chunk_last;) {
+      if (!well_formed.load (std::memory_order_relaxed)) {
+        return;
+      }
+      auto const* const block_last = pos + std::min (block_size, chunk_last - pos);
+      if (!details::validate (t, pos, block_last)) {
+        well_formed.store (false, std::memory_order_relaxed);
+        return;
+      }
+      pos = block_last;
+    }
+    if (chunk == chunks - 1U) {
+      t.end_cp (details::counting_iterator{});
+      if (!t.well_formed ()) {
+        well_formed.store (false, std::memory_order_relaxed);
+      }
+    }
+    assert ((chunk == chunks - 1U || !t.partial ()) && "chunk did not end at a code point boundary");
+  });
+  return well_formed.load (std::memory_order_relaxed);
+}
+
+/// Transcodes a collection of independent jobs using multiple worker threads.
+/// Jobs larger than twice the policy's minimum chunk size are split into
+/// pieces at positions where transcoding can restart without changing the
+/// result so that a single large job does not leave the other threads idle.
+/// Tasks are dealt to per-thread queues, largest first, and a thread whose
+/// queue is empty steals work from the others. A job which is not split is
+/// transcoded directly into its output vector. The first piece of a split job
+/// is also written to the job's output vector; the remaining pieces are
+/// written to vectors of their own which are appended once all of the tasks
+/// are complete.
+///
+/// There is no persistent thread pool: the worker threads are created by each
+/// call and joined before it returns. Creating a thread typically costs some
+/// tens of microseconds, so batches of jobs should be large enough to amortize
+/// this.
+///
+/// \tparam From  The encoding of the input code units.
+/// \tparam To  The encoding of the output code units.
+/// \param policy  Controls the number of threads and the size at which jobs are split.
+/// \param first  The start of the range of jobs.
+/// \param last  The end of the range of jobs.
+template <typename From, typename To, typename RandomAccessIterator>
+ICUBABY_REQUIRES ((unicode_char_type<From> && unicode_char_type<To> &&
+                   std::random_access_iterator<RandomAccessIterator>))
+void transcode_jobs (parallel_policy const& policy, RandomAccessIterator first, RandomAccessIterator last) {
+  struct task {
+    std::size_t job = 0;
+    std::size_t piece = 0;  // The index of this task's entry in 'pieces'.
+    From const* first = nullptr;
+    From const* last = nullptr;
+    bool last_piece = true;
+  };
+  struct piece_result {
+    std::vector<To> output;
+    bool well_formed = true;
+  };
+  struct split_job {
+    std::size_t job = 0;
+    std::size_t first_piece = 0;  // The job's pieces are consecutive entries in 'pieces'.
+    std::size_t last_piece = 0;
+  };
+
+  auto const jobs = static_cast<std::size_t> (std::distance (first, last));
+  auto const min_chunk_size = std::max (policy.min_chunk_size, std::size_t{1});
+  std::vector<task> tasks;
+  tasks.reserve (jobs);
+  std::vector<char> is_split (jobs);
+  std::vector<split_job> split_jobs;
+  std::vector<piece_result> pieces;
+  for (auto job = std::size_t{0}; job < jobs; ++job) {
+    auto const& j = first[static_cast<std::ptrdiff_t> (job)];
+    auto const parts = static_cast<std::size_t> (j.last - j.first) / min_chunk_size;
+    auto const first_piece = pieces.size ();
+    if (parts >= 2U) {
+      auto const* prev = j.first;
+      details::split (j.first, j.last, parts, [&] (From const* pos) {
+        tasks.push_back (task{job, pieces.size (), prev, pos, pos == j.last});
+        pieces.emplace_back ();
+        prev = pos;
+      });
+    }
+    if (pieces.size () - first_piece > 1U) {
+      is_split[job] = 1;
+      split_jobs.push_back (split_job{job, first_piece, pieces.size ()});
+      continue;
+    }
+    // The job is small or there was no safe place to split it.
+    if (pieces.size () != first_piece) {
+      pieces.pop_back ();
+      tasks.pop_back ();
+    }
+    tasks.push_back (task{job, 0, j.first, j.last, true});
+  }
+  // Deal the largest tasks first so that the work is spread evenly before any stealing is needed. Each
+  // worker runs the tasks in its queue in the order they were dealt (largest first).
+  std::stable_sort (tasks.begin (), tasks.end (),
+                    [] (task const& a, task const& b) { return a.last - a.first > b.last - b.first; });
+
+  auto const workers = std::clamp (tasks.size (), std::size_t{1}, std::size_t{details::thread_count (policy)});
+  details::work_queues<task> queues{workers};
+  for (auto index = std::size_t{0}; index < tasks.size (); ++index) {
+    queues.push (index % workers, tasks[index]);
+  }
+  details::parallel_for (workers, [&] (std::size_t worker) {
+    while (auto const next = queues.pop (worker)) {
+      auto& j = first[static_cast<std::ptrdiff_t> (next->job)];
+      // Unsplit jobs and the first piece of a split job write to the job's own output vector.
+      auto const direct = is_split[next->job] == 0 || next->first == j.first;
+      auto& output = direct ? j.output : pieces[next->piece].output;
+      output.clear ();
+      output.reserve (static_cast<std::size_t> (next->last - next->first));
+      transcoder<From, To> t;
+      auto out = transcode (t, next->first, next->last, std::back_inserter (output));
+      if (next->last_piece) {
+        t.end_cp (out);
+      }
+      assert ((next->last_piece || !t.partial ()) && "piece did not end at a code point boundary");
+      if (is_split[next->job] != 0) {
+        pieces[next->piece].well_formed = t.well_formed ();
+      } else {
+        j.well_formed = t.well_formed ();
+      }
+    }
+  });
+
+  // Append the remaining pieces of the jobs which were split.
+  for (auto const& sj : split_jobs) {
+    auto& j = first[static_cast<std::ptrdiff_t> (sj.job)];
+    auto const pf = pieces.begin () + static_cast<std::ptrdiff_t> (sj.first_piece);
+    auto const pl = pieces.begin () + static_cast<std::ptrdiff_t> (sj.last_piece);
+    j.output.reserve (std::accumulate (std::next (pf), pl, j.output.size (),
+                                       [] (std::size_t acc, piece_result const& p) { return acc + p.output.size (); }));
+    for (auto it = std::next (pf); it != pl; ++it) {
+      j.output.insert (j.output.end (), it->output.begin (), it->output.end ());
+    }
+    j.well_formed = std::all_of (pf, pl, [] (piece_result const& p) { return p.well_formed; });
+  }
+}
+
+}  // end namespace icubaby
+
+#ifdef ICUBABY_INSIDE_NS
+}  // end namespace ICUBABY_INSIDE_NS
+#endif
+
+#endif  // ICUBABY_PARALLEL_HPP
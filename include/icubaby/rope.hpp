@@ -0,0 +1,426 @@
+//*  _         _          _          *
+//* (_)__ _  _| |__  __ _| |__ _  _  *
+//* | / _| || | '_ \/ _` | '_ \ || | *
+//* |_\__|\_,_|_.__/\__,_|_.__/\_, | *
+//*                            |__/  *
+// Home page:
+// https://paulhuggett.github.io/icubaby/
+//
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/// \file   rope.hpp
+/// \brief  A UTF-8 text container which supports efficient editing and
+///   translation between code unit, UTF-16, and code point offsets.
+
+#ifndef ICUBABY_ROPE_HPP
+#define ICUBABY_ROPE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "icubaby/icubaby.hpp"
+
+#ifdef ICUBABY_INSIDE_NS
+namespace ICUBABY_INSIDE_NS {
+#endif
+
+namespace icubaby {
+
+/// A sequence of UTF-8 code units stored as a balanced tree of chunks. Each
+/// node records the number of code units, UTF-16 code units, and code points in
+/// its chunk and in its subtree. Finding a code point by any of these offsets,
+/// inserting, and erasing therefore take time proportional to the logarithm of
+/// the number of chunks plus the size of a single chunk; there is no need to
+/// revisit the rest of the text. Chunks are only ever divided at the start of a
+/// code point and code points are delimited as described for utf8_offset_map,
+/// so the offsets recorded for each chunk are exactly those that would be found
+/// by measuring the whole text. Editing combines or redivides chunks so that,
+/// unless there is only one, each holds at least min_chunk_size code units.
+///
+/// The tree is a treap: a binary search tree ordered by offset which is also a
+/// heap ordered by a pseudo-random priority assigned to each node.
+class rope {
+public:
+  /// The offset of a code point expressed in each of the supported units.
+  using position = utf8_offset_map::position;
+
+  /// The maximum number of code units held by a single chunk. A chunk may be
+  /// larger only if ill-formed input leaves no code point start near this size.
+  static constexpr std::size_t max_chunk_size = 1024;
+  /// The minimum number of code units held by a chunk unless it is the only one
+  /// (or ill-formed input leaves no code point start at which to divide it).
+  static constexpr std::size_t min_chunk_size = max_chunk_size / 4;
+
+  rope () noexcept = default;
+  /// Creates a rope containing the code units [first, last).
+  ///
+  /// \param first  The start of the range of code units.
+  /// \param last  The end of the range of code units.
+  rope (char8 const* first, char8 const* last) { this->insert (0, first, last); }
+  rope (rope const& other) : root_{clone (other.root_.get ())}, seed_{other.seed_} {}
+  rope (rope&& other) noexcept = default;
+  ~rope () noexcept = default;
+
+  rope& operator= (rope const& other) {
+    if (&other != this) {
+      root_ = clone (other.root_.get ());
+      seed_ = other.seed_;
+    }
+    return *this;
+  }
+  rope& operator= (rope&& other) noexcept = default;
+
+  /// \returns  True if the rope contains no code units.
+  [[nodiscard]] bool empty () const noexcept { return root_ == nullptr; }
+  /// \returns  The position of the end of the text: its size in each unit.
+  [[nodiscard]] position end () const noexcept { return root_ ? root_->total : position{}; }
+
+  /// \param offset  An offset in UTF-8 code units.
+  /// \returns  The position of the code point containing \p offset.
+  [[nodiscard]] position from_utf8 (std::size_t offset) const { return this->find (&position::utf8, offset); }
+  /// \param offset  An offset in UTF-16 code units.
+  /// \returns  The position of the code point containing \p offset.
+  [[nodiscard]] position from_utf16 (std::size_t offset) const { return this->find (&position::utf16, offset); }
+  /// \param offset  An offset in code points.
+  /// \returns  The position of code point \p offset.
+  [[nodiscard]] position from_code_point (std::size_t offset) const {
+    return this->find (&position::code_point, offset);
+  }
+
+  /// Inserts the code units [first, last) before code point \p pos. If \p pos
+  /// is beyond the end of the text, the code units are appended.
+  ///
+  /// \param pos  The code point before which the code units are inserted.
+  /// \param first  The start of the range of code units to insert.
+  /// \param last  The end of the range of code units to insert.
+  void insert (std::size_t pos, char8 const* first, char8 const* last) {
+    if (first == last) {
+      return;
+    }
+    auto [left, right] = split (std::move (root_), pos);
+    root_ = this->join (this->join (std::move (left), this->make_tree (first, last)), std::move (right));
+  }
+
+  /// Removes \p count code points starting with code point \p pos.
+  ///
+  /// \param pos  The first code point to remove.
+  /// \param count  The number of code points to remove.
+  void erase (std::size_t pos, std::size_t count) {
+    auto [left, rest] = split (std::move (root_), pos);
+    // The middle part holds the erased code points and is discarded.
+    auto right = split (std::move (rest), count).second;
+    root_ = this->join (std::move (left), std::move (right));
+  }
+
+  /// Calls \p f with the code units of each chunk in turn.
+  ///
+  /// \param f  A function which is called with the first and last code units of each chunk.
+  template <typename Function> void for_each_chunk (Function f) const { for_each (root_.get (), f); }
+
+  /// \returns  The contents of the rope.
+  [[nodiscard]] std::basic_string<char8> str () const {
+    std::basic_string<char8> result;
+    result.reserve (this->end ().utf8);
+    this->for_each_chunk ([&result] (char8 const* first, char8 const* last) { result.append (first, last); });
+    return result;
+  }
+
+private:
+  struct node;
+  using node_ptr = std::unique_ptr<node>;
+  struct node {
+    std::basic_string<char8> text;
+    /// The size of this node's chunk.
+    position chunk;
+    /// The size of this node's chunk together with its children.
+    position total;
+    std::uint32_t priority = 0;
+    node_ptr left;
+    node_ptr right;
+  };
+
+  static constexpr position add (position const& lhs, position const& rhs) noexcept {
+    return {lhs.utf8 + rhs.utf8, lhs.utf16 + rhs.utf16, lhs.code_point + rhs.code_point};
+  }
+  static position total (node_ptr const& n) noexcept { return n ? n->total : position{}; }
+
+  /// Counts the code units, UTF-16 code units, and code points in \p text.
+  static position measure (std::basic_string<char8> const& text) noexcept {
+    auto const* const first = text.data ();
+    return details::walk_utf8 (first, first + text.size (), position{}, &position::utf8, text.size ());
+  }
+  static void update (node& n) noexcept { n.total = add (add (total (n.left), n.chunk), total (n.right)); }
+
+  node_ptr make_node (char8 const* first, char8 const* last) {
+    // Xorshift: the priorities need only be well distributed, not unpredictable.
+    seed_ ^= seed_ << 13U;
+    seed_ ^= seed_ >> 17U;
+    seed_ ^= seed_ << 5U;
+    auto result = std::make_unique<node> ();
+    result->text.assign (first, last);
+    result->chunk = measure (result->text);
+    result->priority = seed_;
+    update (*result);
+    return result;
+  }
+
+  /// Builds a tree holding the code units [first, last). The code units are
+  /// divided into as few chunks as max_chunk_size allows, each of roughly the
+  /// same size, so that none is smaller than min_chunk_size.
+  node_ptr make_tree (char8 const* first, char8 const* last) {
+    auto result = node_ptr{};
+    while (first != last) {
+      auto const size = static_cast<std::size_t> (last - first);
+      auto const chunks = (size + max_chunk_size - 1U) / max_chunk_size;
+      auto const* const chunk_end = chunks == 1U ? last : boundary (first + (size + chunks - 1U) / chunks, last);
+      result = merge (std::move (result), this->make_node (first, chunk_end));
+      first = chunk_end;
+    }
+    return result;
+  }
+
+  /// \returns  The start of a code point near \p pos: no more than the longest
+  ///   sequence before it or, if ill-formed input has no such code point start,
+  ///   the first after it (or \p last).
+  static char8 const* boundary (char8 const* pos, char8 const* last) noexcept {
+    auto const* start = pos;
+    for (auto ctr = 1U; ctr < longest_sequence_v<char8> && !is_code_point_start (*start); ++ctr) {
+      --start;
+    }
+    return is_code_point_start (*start) ? start
+                                        : std::find_if (pos, last, [] (char8 c) { return is_code_point_start (c); });
+  }
+
+  static node_ptr clone (node const* n) {
+    if (n == nullptr) {
+      return nullptr;
+    }
+    auto result = std::make_unique<node> ();
+    result->text = n->text;
+    result->chunk = n->chunk;
+    result->total = n->total;
+    result->priority = n->priority;
+    result->left = clone (n->left.get ());
+    result->right = clone (n->right.get ());
+    return result;
+  }
+
+  template <typename Function> static void for_each (node const* n, Function& f) {
+    if (n != nullptr) {
+      for_each (n->left.get (), f);
+      f (n->text.data (), n->text.data () + n->text.size ());
+      for_each (n->right.get (), f);
+    }
+  }
+
+  /// Splits the tree \p n into two: the first holding code points [0, pos) and
+  /// the second holding the remainder. A chunk containing both is divided.
+  static std::pair<node_ptr, node_ptr> split (node_ptr n, std::size_t pos) {
+    if (!n) {
+      return {};
+    }
+    auto const left_size = total (n->left).code_point;
+    if (pos <= left_size) {
+      auto [first, second] = split (std::move (n->left), pos);
+      n->left = std::move (second);
+      update (*n);
+      return {std::move (first), std::move (n)};
+    }
+    pos -= left_size;
+    if (pos >= n->chunk.code_point) {
+      auto [first, second] = split (std::move (n->right), pos - n->chunk.code_point);
+      n->right = std::move (first);
+      update (*n);
+      return {std::move (n), std::move (second)};
+    }
+    // Divide this node's chunk. The tail takes the node's priority so that it
+    // may become the parent of the node's right subtree.
+    auto const* const text = n->text.data ();
+    auto const at = details::walk_utf8 (text, text + n->text.size (), position{}, &position::code_point, pos);
+    auto tail = std::make_unique<node> ();
+    tail->text = n->text.substr (at.utf8);
+    tail->chunk = measure (tail->text);
+    tail->priority = n->priority;
+    tail->right = std::move (n->right);
+    update (*tail);
+    n->text.resize (at.utf8);
+    n->chunk = at;
+    update (*n);
+    return {std::move (n), std::move (tail)};
+  }
+
+  /// Joins the trees \p lhs and \p rhs. Every code point of \p lhs precedes those of \p rhs.
+  static node_ptr merge (node_ptr lhs, node_ptr rhs) {
+    if (!lhs) {
+      return rhs;
+    }
+    if (!rhs) {
+      return lhs;
+    }
+    if (lhs->priority >= rhs->priority) {
+      lhs->right = merge (std::move (lhs->right), std::move (rhs));
+      update (*lhs);
+      return lhs;
+    }
+    rhs->left = merge (std::move (lhs), std::move (rhs->left));
+    update (*rhs);
+    return rhs;
+  }
+
+  /// Joins the trees \p lhs and \p rhs as merge() does and then tidies the
+  /// chunks on either side of the join. Other than at their ends, the trees'
+  /// chunks already hold at least min_chunk_size code units. A chunk at the
+  /// join which is smaller than that (or which begins with continuation code
+  /// units that belong to the code point before it) is combined with its
+  /// neighbour if they fit within max_chunk_size. If they don't, the code units
+  /// of the two are divided afresh close to their middle.
+  node_ptr join (node_ptr lhs, node_ptr rhs) {
+    // A small chunk at the end of the text has only one neighbour.
+    if (!rhs && lhs && (lhs->left || lhs->right)) {
+      rhs = take_last (lhs);
+    } else if (!lhs && rhs && (rhs->left || rhs->right)) {
+      lhs = take_first (rhs);
+    }
+    while (lhs && rhs) {
+      auto const& tail = last_chunk (*lhs).text;
+      auto const& head = first_chunk (*rhs).text;
+      if (tail.size () >= min_chunk_size && head.size () >= min_chunk_size && is_code_point_start (head.front ())) {
+        break;
+      }
+      if (tail.size () + head.size () > max_chunk_size) {
+        auto const text = tail + head;
+        auto const* const first = text.data ();
+        auto const* const last = first + text.size ();
+        auto const* const middle = boundary (first + text.size () / 2U, last);
+        modify_last (*lhs, [first, middle] (std::basic_string<char8>& t) { t.assign (first, middle); });
+        if (middle == last) {
+          take_first (rhs);
+        } else {
+          modify_first (*rhs, [middle, last] (std::basic_string<char8>& t) { t.assign (middle, last); });
+        }
+        break;
+      }
+      auto const moved = take_first (rhs);
+      modify_last (*lhs, [&moved] (std::basic_string<char8>& t) { t += moved->text; });
+      if (!rhs && (lhs->left || lhs->right) && last_chunk (*lhs).text.size () < min_chunk_size) {
+        rhs = take_last (lhs);
+      }
+    }
+    return merge (std::move (lhs), std::move (rhs));
+  }
+
+  static node const& first_chunk (node const& n) noexcept { return n.left ? first_chunk (*n.left) : n; }
+  static node const& last_chunk (node const& n) noexcept { return n.right ? last_chunk (*n.right) : n; }
+
+  /// Removes the first node of the tree \p n.
+  ///
+  /// \returns  The removed node.
+  static node_ptr take_first (node_ptr& n) {
+    if (n->left) {
+      auto result = take_first (n->left);
+      update (*n);
+      return result;
+    }
+    auto result = std::move (n);
+    n = std::move (result->right);
+    update (*result);
+    return result;
+  }
+  /// Removes the last node of the tree \p n.
+  ///
+  /// \returns  The removed node.
+  static node_ptr take_last (node_ptr& n) {
+    if (n->right) {
+      auto result = take_last (n->right);
+      update (*n);
+      return result;
+    }
+    auto result = std::move (n);
+    n = std::move (result->left);
+    update (*result);
+    return result;
+  }
+
+  /// Calls \p f with the text of the first chunk of tree \p n and then updates
+  /// the sizes recorded in the tree.
+  template <typename Function> static void modify_first (node& n, Function f) {
+    if (n.left) {
+      modify_first (*n.left, f);
+    } else {
+      f (n.text);
+      n.chunk = measure (n.text);
+    }
+    update (n);
+  }
+  /// Calls \p f with the text of the final chunk of tree \p n and then updates
+  /// the sizes recorded in the tree.
+  template <typename Function> static void modify_last (node& n, Function f) {
+    if (n.right) {
+      modify_last (*n.right, f);
+    } else {
+      f (n.text);
+      n.chunk = measure (n.text);
+    }
+    update (n);
+  }
+
+  [[nodiscard]] position find (std::size_t position::*key, std::size_t offset) const {
+    if (offset >= this->end ().*key) {
+      return this->end ();
+    }
+    auto base = position{};
+    auto const* n = root_.get ();
+    for (;;) {
+      assert (n != nullptr);
+      auto const left = total (n->left);
+      if (offset < base.*key + left.*key) {
+        n = n->left.get ();
+        continue;
+      }
+      base = add (base, left);
+      if (offset < base.*key + n->chunk.*key) {
+        auto const* const text = n->text.data ();
+        return details::walk_utf8 (text, text + n->text.size (), base, key, offset);
+      }
+      base = add (base, n->chunk);
+      n = n->right.get ();
+    }
+  }
+
+  node_ptr root_;
+  /// The state of the generator of node priorities.
+  std::uint32_t seed_ = 2463534242U;
+};
+
+}  // end namespace icubaby
+
+#ifdef ICUBABY_INSIDE_NS
+}  // end namespace ICUBABY_INSIDE_NS
+#endif
+
+#endif  // ICUBABY_ROPE_HPP
@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Compares the throughput of the UTF-8 decoding engines (table_dfa and
+// shift_dfa), both one byte at a time and interleaved across four streams by
+// decode_interleaved(), over inputs with an increasing proportion of non-ASCII
+// code points.
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "icubaby/icubaby.hpp"
+
+namespace {
+
+/// Returns approximately \p size bytes of UTF-8 in which \p percent percent of
+/// the code points are drawn from outside the ASCII range.
+std::vector<icubaby::char8> make_input (std::size_t size, unsigned percent) {
+  static std::array<std::u32string, 2> const samples{{U"abcdefghij", U"éЖこ\U0001F600"}};
+  std::vector<icubaby::char8> result;
+  result.reserve (size + 4);
+  icubaby::t32_8 encoder;
+  auto out = std::back_inserter (result);
+  auto seed = std::uint32_t{1};
+  for (auto ctr = std::size_t{0}; result.size () < size; ++ctr) {
+    seed = seed * 1103515245U + 12345U;
+    auto const& sample = samples[(seed >> 16U) % 100U < percent ? 1U : 0U];
+    out = encoder (sample[ctr % sample.size ()], out);
+  }
+  return result;
+}
+
+/// An output iterator which folds the code points written to it into a
+/// checksum so that the work of decoding cannot be optimized away.
+struct sink {
+  using iterator_category = std::output_iterator_tag;
+  using value_type = void;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = void;
+
+  char32_t* sum;
+  sink& operator* () { return *this; }
+  sink& operator++ () { return *this; }
+  sink operator++ (int) { return *this; }
+  sink& operator= (char32_t c) {
+    *sum ^= c;
+    return *this;
+  }
+};
+
+/// Decodes \p input using \p Decoder \p iterations times and returns the
+/// throughput in MB/s.
+template <typename Decoder> double measure (std::vector<icubaby::char8> const& input, unsigned iterations) {
+  auto checksum = char32_t{0};
+  auto const start = std::chrono::steady_clock::now ();
+  for (auto iteration = 0U; iteration < iterations; ++iteration) {
+    Decoder d;
+    auto out = sink{&checksum};
+    for (auto const cu : input) {
+      out = d (cu, out);
+    }
+    d.end_cp (out);
+  }
+  auto const elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  // Ensure that the checksum is observed.
+  char32_t volatile observed = checksum;
+  (void)observed;
+  return static_cast<double> (input.size ()) * iterations / elapsed / 1e6;
+}
+
+/// Decodes \p input with decode_interleaved() \p iterations times and returns
+/// the throughput in MB/s.
+template <std::size_t Streams, typename Engine>
+double measure_interleaved (std::vector<icubaby::char8> const& input, unsigned iterations) {
+  std::vector<char32_t> output (icubaby::max_transcoded_size<icubaby::char8, char32_t> (input.size ()));
+  auto checksum = char32_t{0};
+  auto const start = std::chrono::steady_clock::now ();
+  for (auto iteration = 0U; iteration < iterations; ++iteration) {
+    auto const* const first = input.data ();
+    auto const* const end =
+        icubaby::decode_interleaved<Streams, Engine> (first, first + input.size (), output.data ());
+    checksum ^= end == output.data () ? char32_t{0} : *(end - 1);
+  }
+  auto const elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  char32_t volatile observed = checksum;
+  (void)observed;
+  return static_cast<double> (input.size ()) * iterations / elapsed / 1e6;
+}
+
+}  // end anonymous namespace
+
+int main () {
+  constexpr auto size = std::size_t{1} << 20U;
+  constexpr auto iterations = 20U;
+  std::cout << std::setw (12) << "% non-ASCII" << std::setw (14) << "table MB/s" << std::setw (14) << "shift MB/s"
+            << std::setw (14) << "table x4" << std::setw (14) << "shift x4" << '\n';
+  for (auto const percent : {0U, 1U, 5U, 10U, 25U, 50U, 75U, 100U}) {
+    auto const input = make_input (size, percent);
+    auto const table = measure<icubaby::utf8_decoder<icubaby::table_dfa>> (input, iterations);
+    auto const shift = measure<icubaby::utf8_decoder<icubaby::shift_dfa>> (input, iterations);
+    auto const table4 = measure_interleaved<4, icubaby::table_dfa> (input, iterations);
+    auto const shift4 = measure_interleaved<4, icubaby::shift_dfa> (input, iterations);
+    std::cout << std::setw (12) << percent << std::fixed << std::setprecision (1) << std::setw (14) << table
+              << std::setw (14) << shift << std::setw (14) << table4 << std::setw (14) << shift4 << '\n';
+  }
+}
@@ -0,0 +1,124 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+/// A column of strings stored as a buffer of code units and an array of offsets.
+template <typename T> struct column {
+  explicit column (std::vector<std::basic_string<T>> const& strings) {
+    offsets.push_back (0);
+    for (auto const& str : strings) {
+      data.insert (data.end (), str.begin (), str.end ());
+      offsets.push_back (static_cast<std::int32_t> (data.size ()));
+    }
+  }
+  std::basic_string<T> at (std::size_t index) const {
+    return {data.begin () + offsets[index], data.begin () + offsets[index + 1U]};
+  }
+
+  std::vector<T> data;
+  std::vector<std::int32_t> offsets;
+};
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (TranscodeColumn, Utf16To8) {
+  std::vector<std::u16string> const strings{
+      u"Hello",   u"", u"World", u"\u3053\u3093\u306B\u3061\u306F", u"\U0001F600",
+      u"\xD800!",  // A lone high surrogate.
+      u"ASCII after an error"};
+  column<char16_t> const in{strings};
+
+  std::vector<icubaby::char8> out_data (icubaby::max_transcoded_size<char16_t, icubaby::char8> (in.data.size ()));
+  std::vector<std::int32_t> out_offsets (strings.size () + 1U);
+  std::vector<std::uint8_t> validity ((strings.size () + 7U) / 8U);
+  auto const size = icubaby::transcode_column (in.data.data (), in.offsets.data (), strings.size (), out_data.data (),
+                                               out_offsets.data (), validity.data ());
+  out_data.resize (size);
+
+  ASSERT_EQ (static_cast<std::size_t> (out_offsets.back ()), size);
+  for (auto index = std::size_t{0}; index < strings.size (); ++index) {
+    std::vector<icubaby::char8> expected;
+    icubaby::t16_8 t;
+    t.end_cp (std::copy (strings[index].begin (), strings[index].end (),
+                         icubaby::iterator{&t, std::back_inserter (expected)}));
+    std::vector<icubaby::char8> const actual (out_data.begin () + out_offsets[index],
+                                              out_data.begin () + out_offsets[index + 1U]);
+    EXPECT_EQ (actual, expected) << "String " << index;
+    EXPECT_EQ ((validity[index / 8U] >> (index % 8U)) & 1U, t.well_formed () ? 1U : 0U) << "String " << index;
+  }
+}
+// NOLINTNEXTLINE
+TEST (TranscodeColumn, Utf8To16AllAscii) {
+  std::vector<std::u16string> const strings{u"a", u"bc", u"", u"def", u"ghij", u"klmno", u"pqrstu", u"vwxyz"};
+  std::vector<std::basic_string<icubaby::char8>> strings8;
+  for (auto const& str : strings) {
+    strings8.emplace_back (str.begin (), str.end ());
+  }
+  column<icubaby::char8> const in{strings8};
+
+  std::vector<char16_t> out_data (icubaby::max_transcoded_size<icubaby::char8, char16_t> (in.data.size ()));
+  std::vector<std::int32_t> out_offsets (strings.size () + 1U);
+  std::vector<std::uint8_t> validity{0x00};
+  auto const size = icubaby::transcode_column (in.data.data (), in.offsets.data (), strings.size (), out_data.data (),
+                                               out_offsets.data (), validity.data ());
+  EXPECT_EQ (size, in.data.size ());
+  EXPECT_EQ (out_offsets, in.offsets);
+  EXPECT_THAT (validity, ElementsAre (std::uint8_t{0xFF}));
+  for (auto index = std::size_t{0}; index < strings.size (); ++index) {
+    EXPECT_EQ (std::u16string (out_data.begin () + out_offsets[index], out_data.begin () + out_offsets[index + 1U]),
+               strings[index]);
+  }
+}
+// NOLINTNEXTLINE
+TEST (TranscodeColumn, Utf8Malformed) {
+  // The truncated sequence at the end of the first string must not swallow
+  // the first code unit of the second.
+  std::vector<std::basic_string<icubaby::char8>> strings8{{static_cast<icubaby::char8> (0xE3)}, {'A', 'B'}};
+  column<icubaby::char8> const in{strings8};
+  std::vector<char32_t> out_data (icubaby::max_transcoded_size<icubaby::char8, char32_t> (in.data.size ()));
+  std::vector<std::int32_t> out_offsets (strings8.size () + 1U);
+  auto const size = icubaby::transcode_column (in.data.data (), in.offsets.data (), strings8.size (), out_data.data (),
+                                               out_offsets.data (), nullptr);
+  out_data.resize (size);
+  EXPECT_THAT (out_data, ElementsAre (icubaby::replacement_char, char32_t{'A'}, char32_t{'B'}));
+  EXPECT_THAT (out_offsets, ElementsAre (0, 1, 3));
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#if ICUBABY_HAVE_COROUTINES && ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
+
+using testing::ElementsAreArray;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+class Generate : public testing::Test {
+protected:
+  Generate () {
+    // Repeat a mixture of one, two, three, and four byte UTF-8 sequences.
+    for (auto ctr = 0; ctr < 100; ++ctr) {
+      for (auto const cu : {0x41, 0xC2, 0xA2, 0xE2, 0x82, 0xAC, 0xF0, 0x9F, 0x98, 0x80}) {
+        in_.push_back (static_cast<icubaby::char8> (cu));
+      }
+    }
+    icubaby::t8_16 t;
+    t.end_cp (std::copy (in_.begin (), in_.end (), icubaby::iterator{&t, std::back_inserter (expected_)}));
+  }
+
+  template <typename Generator> static std::vector<char16_t> collect (Generator&& gen, std::size_t batch_size) {
+    // Every batch but the last must hold exactly batch_size code units.
+    std::vector<char16_t> result;
+    std::size_t last_size = batch_size;
+    for (auto const& span : gen) {
+      EXPECT_EQ (last_size, batch_size);
+      EXPECT_FALSE (span.empty ());
+      EXPECT_LE (span.size (), batch_size);
+      last_size = span.size ();
+      result.insert (result.end (), span.begin (), span.end ());
+    }
+    return result;
+  }
+
+  std::vector<icubaby::char8> in_;
+  std::vector<char16_t> expected_;
+};
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST_F (Generate, Contiguous) {
+  EXPECT_THAT (collect (icubaby::generate<icubaby::char8, char16_t, 16> (in_), 16), ElementsAreArray (expected_));
+}
+// NOLINTNEXTLINE
+TEST_F (Generate, NonContiguous) {
+  std::list<icubaby::char8> const in (in_.begin (), in_.end ());
+  EXPECT_THAT (collect (icubaby::generate<icubaby::char8, char16_t, 16> (in), 16), ElementsAreArray (expected_));
+}
+// NOLINTNEXTLINE
+TEST_F (Generate, BatchSizeOne) {
+  // A single input code unit can produce more output than fits in one batch.
+  EXPECT_THAT (collect (icubaby::generate<icubaby::char8, char16_t, 1> (in_), 1), ElementsAreArray (expected_));
+  std::list<icubaby::char8> const in (in_.begin (), in_.end ());
+  EXPECT_THAT (collect (icubaby::generate<icubaby::char8, char16_t, 1> (in), 1), ElementsAreArray (expected_));
+}
+// NOLINTNEXTLINE
+TEST_F (Generate, DefaultBatchSize) {
+  EXPECT_THAT (collect (icubaby::generate<icubaby::char8, char16_t> (in_), icubaby::generate_batch_size),
+               ElementsAreArray (expected_));
+}
+// NOLINTNEXTLINE
+TEST_F (Generate, Empty) {
+  std::vector<icubaby::char8> const empty;
+  auto gen = icubaby::generate<icubaby::char8, char16_t> (empty);
+  EXPECT_EQ (gen.begin (), gen.end ());
+}
+// NOLINTNEXTLINE
+TEST_F (Generate, ExternalTranscoder) {
+  // A truncated code point at the end of the input is reported by the
+  // transcoder once the generator is exhausted.
+  in_.push_back (static_cast<icubaby::char8> (0xE2));
+  expected_.push_back (static_cast<char16_t> (icubaby::replacement_char));
+  icubaby::t8_16 t;
+  EXPECT_THAT (collect (icubaby::generate<4> (t, in_), 4), ElementsAreArray (expected_));
+  EXPECT_FALSE (t.well_formed ());
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+#endif  // ICUBABY_HAVE_COROUTINES && ICUBABY_HAVE_RANGES && ICUBABY_HAVE_CONCEPTS
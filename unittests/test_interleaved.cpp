@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAreArray;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+template <std::size_t Streams, typename Engine> void check_interleaved (std::vector<icubaby::char8> const& in) {
+  std::vector<char32_t> expected;
+  icubaby::t8_32 t;
+  t.end_cp (std::copy (in.begin (), in.end (), icubaby::iterator{&t, std::back_inserter (expected)}));
+
+  std::vector<char32_t> actual (icubaby::max_transcoded_size<icubaby::char8, char32_t> (in.size ()));
+  auto well_formed = !t.well_formed ();
+  auto* const end = icubaby::decode_interleaved<Streams, Engine> (in.data (), in.data () + in.size (), actual.data (),
+                                                                  &well_formed);
+  actual.resize (static_cast<std::size_t> (end - actual.data ()));
+  EXPECT_THAT (actual, ElementsAreArray (expected)) << "Streams=" << Streams << " size=" << in.size ();
+  EXPECT_EQ (well_formed, t.well_formed ());
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (DecodeInterleaved, MatchesTranscoder) {
+  std::vector<icubaby::char8> in;
+  for (auto ctr = 0U; ctr < 300U; ++ctr) {
+    // Mostly well formed text with an occasional stray continuation byte.
+    for (auto const c : {0x48, 0x69, 0xC3, 0xA9, 0xE3, 0x81, 0x93, 0xF0, 0x9F, 0x98, 0x80, 0x20}) {
+      in.push_back (static_cast<icubaby::char8> (c));
+    }
+    if (ctr % 97U == 96U) {
+      in.push_back (static_cast<icubaby::char8> (0x80));
+    }
+  }
+  for (auto const size : {std::size_t{0}, std::size_t{5}, std::size_t{100}, std::size_t{1001}, in.size ()}) {
+    std::vector<icubaby::char8> const part (in.begin (), in.begin () + static_cast<std::ptrdiff_t> (size));
+    check_interleaved<1, icubaby::table_dfa> (part);
+    check_interleaved<4, icubaby::table_dfa> (part);
+    check_interleaved<8, icubaby::shift_dfa> (part);
+  }
+  // Input which ends part way through a code point.
+  in.push_back (static_cast<icubaby::char8> (0xE3));
+  check_interleaved<4, icubaby::table_dfa> (in);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
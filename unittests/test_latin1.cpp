@@ -0,0 +1,182 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+static_assert (std::is_same_v<icubaby::tl1_8::input_type, icubaby::latin1> &&
+               std::is_same_v<icubaby::tl1_8::output_type, icubaby::char8>);
+static_assert (std::is_same_v<icubaby::t8_l1::input_type, icubaby::char8> &&
+               std::is_same_v<icubaby::t8_l1::output_type, icubaby::latin1>);
+static_assert (icubaby::is_unicode_char_type_v<icubaby::latin1>);
+static_assert (icubaby::max_transcoded_size<icubaby::latin1, icubaby::char8> (3) == 6);
+static_assert (icubaby::max_transcoded_size<icubaby::char8, icubaby::latin1> (3) == 3);
+
+namespace {
+
+/// Transcodes [first, last) using a transcoder of type Transcoder and the
+/// generic output iterator interface.
+template <typename Transcoder, typename InputIterator>
+std::vector<typename Transcoder::output_type> convert (InputIterator first, InputIterator last,
+                                                       bool* well_formed = nullptr) {
+  std::vector<typename Transcoder::output_type> out;
+  Transcoder t;
+  auto it = std::back_inserter (out);
+  for (; first != last; ++first) {
+    it = t (*first, it);
+  }
+  t.end_cp (it);
+  if (well_formed != nullptr) {
+    *well_formed = t.well_formed ();
+  }
+  return out;
+}
+
+std::vector<icubaby::latin1> all_latin1 () {
+  std::vector<icubaby::latin1> result;
+  for (auto c = 0U; c <= 0xFFU; ++c) {
+    result.push_back (static_cast<icubaby::latin1> (c));
+  }
+  return result;
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (Latin1, ToUnicode) {
+  auto const input = all_latin1 ();
+  std::u32string code_points;
+  for (auto c = char32_t{0}; c <= 0xFF; ++c) {
+    code_points += c;
+  }
+  bool well_formed = false;
+  EXPECT_THAT (convert<icubaby::tl1_32> (input.begin (), input.end (), &well_formed),
+               testing::ElementsAreArray (code_points));
+  EXPECT_TRUE (well_formed);
+  EXPECT_THAT (convert<icubaby::tl1_16> (input.begin (), input.end ()),
+               testing::ElementsAreArray (convert<icubaby::t32_16> (code_points.begin (), code_points.end ())));
+  EXPECT_THAT (convert<icubaby::tl1_8> (input.begin (), input.end ()),
+               testing::ElementsAreArray (convert<icubaby::t32_8> (code_points.begin (), code_points.end ())));
+  EXPECT_THAT (convert<icubaby::tl1_l1> (input.begin (), input.end ()), testing::ElementsAreArray (input));
+}
+
+// NOLINTNEXTLINE
+TEST (Latin1, FromUnicode) {
+  auto const expected = all_latin1 ();
+  std::u32string code_points;
+  for (auto c = char32_t{0}; c <= 0xFF; ++c) {
+    code_points += c;
+  }
+  auto const utf8 = convert<icubaby::t32_8> (code_points.begin (), code_points.end ());
+  auto const utf16 = convert<icubaby::t32_16> (code_points.begin (), code_points.end ());
+  bool well_formed = false;
+  EXPECT_THAT (convert<icubaby::t8_l1> (utf8.begin (), utf8.end (), &well_formed),
+               testing::ElementsAreArray (expected));
+  EXPECT_TRUE (well_formed);
+  EXPECT_THAT (convert<icubaby::t16_l1> (utf16.begin (), utf16.end (), &well_formed),
+               testing::ElementsAreArray (expected));
+  EXPECT_TRUE (well_formed);
+  EXPECT_THAT (convert<icubaby::t32_l1> (code_points.begin (), code_points.end (), &well_formed),
+               testing::ElementsAreArray (expected));
+  EXPECT_TRUE (well_formed);
+}
+
+// NOLINTNEXTLINE
+TEST (Latin1, Unmappable) {
+  // U+20AC EURO SIGN, U+D800 (a lone surrogate), and U+00E9 LATIN SMALL LETTER E WITH ACUTE.
+  std::u32string const input{0x20AC, 0xD800, 0xE9};
+  bool well_formed = true;
+  EXPECT_THAT (convert<icubaby::t32_l1> (input.begin (), input.end (), &well_formed),
+               testing::ElementsAre (icubaby::latin1_substitute, icubaby::latin1_substitute, icubaby::latin1{0xE9}));
+  EXPECT_FALSE (well_formed);
+
+  // A truncated UTF-8 sequence is replaced by the substitute when end_cp() is called.
+  std::vector<icubaby::char8> const utf8{static_cast<icubaby::char8> ('a'), static_cast<icubaby::char8> (0xC3)};
+  well_formed = true;
+  EXPECT_THAT (convert<icubaby::t8_l1> (utf8.begin (), utf8.end (), &well_formed),
+               testing::ElementsAre (icubaby::latin1{'a'}, icubaby::latin1_substitute));
+  EXPECT_FALSE (well_formed);
+}
+
+// NOLINTNEXTLINE
+TEST (Latin1, TranscodeToUtf8Buffer) {
+  std::vector<icubaby::latin1> input;
+  for (auto ctr = 0U; ctr < 1000U; ++ctr) {
+    // A mixture of runs of ASCII and of Latin-1 letters.
+    input.push_back (static_cast<icubaby::latin1> (ctr % 97U < 60U ? 'a' + ctr % 26U : 0xC0U + ctr % 64U));
+  }
+  auto const expected = convert<icubaby::tl1_8> (input.begin (), input.end ());
+
+  icubaby::tl1_8 t;
+  std::vector<icubaby::char8> out (expected.size ());
+  auto* const end = icubaby::transcode (t, input.data (), input.data () + input.size (), out.data (),
+                                        out.data () + out.size ());
+  EXPECT_EQ (end, out.data () + out.size ());
+  EXPECT_THAT (out, testing::ContainerEq (expected));
+}
+
+// NOLINTNEXTLINE
+TEST (Latin1, TranscodeFromUtf8Buffer) {
+  std::u32string code_points;
+  for (auto ctr = 0U; ctr < 1000U; ++ctr) {
+    code_points += static_cast<char32_t> (ctr % 89U < 50U ? U'a' + ctr % 26U : 0xA0U + ctr % 96U);
+    if (ctr % 211U == 0U) {
+      code_points += U'\u20AC';
+    }
+  }
+  auto utf8 = convert<icubaby::t32_8> (code_points.begin (), code_points.end ());
+  // A stray continuation byte, then a lead byte in the final lane of a word
+  // whose continuation is in the next and finally a truncated sequence.
+  utf8.push_back (static_cast<icubaby::char8> (0x80));
+  utf8.insert (utf8.end (), 7, static_cast<icubaby::char8> ('x'));
+  utf8.push_back (static_cast<icubaby::char8> (0xC3));
+  utf8.push_back (static_cast<icubaby::char8> (0xA9));
+  utf8.push_back (static_cast<icubaby::char8> (0xC3));
+
+  for (auto offset = std::size_t{0}; offset < 8U; ++offset) {
+    icubaby::t8_l1 expected_t;
+    std::vector<icubaby::latin1> expected;
+    expected_t.end_cp (
+        icubaby::transcode (expected_t, utf8.begin () + offset, utf8.end (), std::back_inserter (expected)));
+
+    icubaby::t8_l1 t;
+    std::vector<icubaby::latin1> out (icubaby::max_transcoded_size<icubaby::char8, icubaby::latin1> (utf8.size ()));
+    auto* const end = icubaby::transcode (t, utf8.data () + offset, utf8.data () + utf8.size (), out.data (),
+                                          out.data () + out.size ());
+    auto* const final = t.end_cp (end);
+    out.resize (static_cast<std::size_t> (final - out.data ()));
+    EXPECT_THAT (out, testing::ContainerEq (expected)) << "offset=" << offset;
+    EXPECT_FALSE (expected_t.well_formed ());
+    EXPECT_FALSE (t.well_formed ());
+  }
+}
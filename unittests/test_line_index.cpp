@@ -0,0 +1,118 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::ElementsAreArray;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+// NOLINTNEXTLINE
+TEST (Transcode, LineIndex) {
+  std::vector<icubaby::char8> in;
+  for (auto ctr = 0; ctr < 20; ++ctr) {
+    for (auto const c : std::string{"first line\n\n"}) {
+      in.push_back (static_cast<icubaby::char8> (c));
+    }
+    for (auto const c : {0xE3, 0x81, 0x93, 0x0A, 0x41, 0xF0, 0x9F, 0x98, 0x80, 0x42, 0x0A, 0x43}) {
+      in.push_back (static_cast<icubaby::char8> (c));
+    }
+  }
+  // Find the expected line starts one code unit at a time.
+  std::vector<std::size_t> unit_starts{0};
+  std::vector<std::size_t> code_point_starts{0};
+  auto code_points = std::size_t{0};
+  for (auto ctr = std::size_t{0}; ctr < in.size (); ++ctr) {
+    code_points += icubaby::is_code_point_start (in[ctr]) ? 1U : 0U;
+    if (in[ctr] == icubaby::char8{0x0A}) {
+      unit_starts.push_back (ctr + 1U);
+      code_point_starts.push_back (code_points);
+    }
+  }
+  std::vector<char32_t> expected;
+  icubaby::t8_32 t1;
+  t1.end_cp (std::copy (in.begin (), in.end (), icubaby::iterator{&t1, std::back_inserter (expected)}));
+
+  // Pass the input in chunks of various sizes.
+  for (auto const chunk : {std::size_t{1}, std::size_t{5}, std::size_t{64}, in.size ()}) {
+    std::vector<char32_t> actual;
+    icubaby::line_index<icubaby::char8> lines;
+    icubaby::t8_32 t2;
+    auto out = std::back_inserter (actual);
+    for (auto pos = std::size_t{0}; pos < in.size (); pos += chunk) {
+      auto const* const first = in.data () + pos;
+      out = icubaby::transcode (t2, first, first + std::min (chunk, in.size () - pos), out, lines);
+    }
+    t2.end_cp (out);
+    EXPECT_THAT (actual, ElementsAreArray (expected));
+    EXPECT_THAT (lines.code_unit_starts (), ElementsAreArray (unit_starts)) << "chunk=" << chunk;
+    EXPECT_THAT (lines.code_point_starts (), ElementsAreArray (code_point_starts)) << "chunk=" << chunk;
+    EXPECT_EQ (lines.size (), unit_starts.size ());
+
+    // The second line is empty and the third begins with U+3053.
+    auto const loc = lines.from_code_unit (unit_starts[2] + 3U);
+    EXPECT_EQ (loc.line, 2U);
+    EXPECT_EQ (loc.column, 3U);
+    auto const cp_loc = lines.from_code_point (code_point_starts[3] + 2U);
+    EXPECT_EQ (cp_loc.line, 3U);
+    EXPECT_EQ (cp_loc.column, 2U);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Transcode, LineIndexUtf16) {
+  std::u16string const in = u"line one\nline \U0001F600 two\n";
+  std::string out;
+  icubaby::line_index<char16_t> lines;
+  icubaby::t16_8 t;
+  t.end_cp (icubaby::transcode (t, in.data (), in.data () + in.size (), std::back_inserter (out), lines));
+  EXPECT_THAT (lines.code_unit_starts (), ElementsAre (0U, 9U, 21U));
+  EXPECT_THAT (lines.code_point_starts (), ElementsAre (0U, 9U, 20U));
+}
+
+// NOLINTNEXTLINE
+TEST (Transcode, LineIndexFromChar) {
+  // The input code units are of type char rather than char8: their values
+  // are converted as they are read.
+  std::string const in = "a line which is long enough to fill several words\nand \xC3\xA9 a second\n";
+  std::u32string out;
+  icubaby::line_index<icubaby::char8> lines;
+  icubaby::t8_32 t;
+  t.end_cp (icubaby::transcode (t, in.data (), in.data () + in.size (), std::back_inserter (out), lines));
+  EXPECT_EQ (out, U"a line which is long enough to fill several words\nand \u00E9 a second\n");
+  EXPECT_THAT (lines.code_unit_starts (), ElementsAre (0U, 50U, 66U));
+  EXPECT_THAT (lines.code_point_starts (), ElementsAre (0U, 50U, 65U));
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAreArray;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+// NOLINTNEXTLINE
+TEST (Transcode, NullTerminated) {
+  // Try each alignment of the start of the string and of the terminator.
+  std::u16string const str = u"Hello, World! \u3053\u3093\u306B\u3061\u306F, \xD800 and more plain ASCII text";
+  std::vector<char16_t> buffer (str.size () + 8);
+  for (auto skip = std::size_t{0}; skip < 4; ++skip) {
+    for (auto length = str.size () - 16; length <= str.size (); ++length) {
+      std::u16string const in = str.substr (0, length);
+      auto const pos = std::copy (in.begin (), in.end (), buffer.begin () + static_cast<std::ptrdiff_t> (skip));
+      std::fill (pos, buffer.end (), char16_t{0});
+
+      std::vector<icubaby::char8> expected;
+      icubaby::t16_8 t1;
+      t1.end_cp (std::copy (in.begin (), in.end (), icubaby::iterator{&t1, std::back_inserter (expected)}));
+
+      std::vector<icubaby::char8> actual;
+      icubaby::t16_8 t2;
+      auto const* const first = buffer.data () + skip;
+      t2.end_cp (icubaby::transcode (t2, first, icubaby::null_terminated, std::back_inserter (actual)));
+      EXPECT_THAT (actual, ElementsAreArray (expected));
+      EXPECT_EQ (t1.well_formed (), t2.well_formed ());
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Transcode, NullTerminatedEmpty) {
+  std::vector<char32_t> out;
+  icubaby::t8_32 t;
+  t.end_cp (icubaby::transcode (t, u8"", icubaby::null_terminated, std::back_inserter (out)));
+  EXPECT_TRUE (out.empty ());
+  EXPECT_TRUE (t.well_formed ());
+}
+
+// NOLINTNEXTLINE
+TEST (Transcode, NullTerminatedExactAllocation) {
+  // Each string is copied to a heap allocation that ends with its terminator
+  // so that any read beyond the terminator is caught by a memory checker.
+  std::string const str = "ASCII text long enough to span several words\xC3\xA9";
+  for (auto length = std::size_t{0}; length <= str.size (); ++length) {
+    auto const buffer = std::make_unique<icubaby::char8[]> (length + 1U);
+    std::transform (str.begin (), str.begin () + static_cast<std::ptrdiff_t> (length), buffer.get (),
+                    [] (char c) { return static_cast<icubaby::char8> (c); });
+    buffer[length] = icubaby::char8{0};
+
+    std::vector<char32_t> expected;
+    icubaby::t8_32 t1;
+    t1.end_cp (icubaby::transcode (t1, buffer.get (), buffer.get () + length, std::back_inserter (expected)));
+
+    std::vector<char32_t> actual;
+    icubaby::t8_32 t2;
+    t2.end_cp (icubaby::transcode (t2, buffer.get (), icubaby::null_terminated, std::back_inserter (actual)));
+    EXPECT_THAT (actual, ElementsAreArray (expected)) << "length=" << length;
+  }
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,222 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+#include "icubaby/parallel.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAreArray;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+/// A policy which splits even small inputs between several threads.
+constexpr icubaby::parallel_policy small_chunks{4, 64};
+
+/// Returns a sequence of \p size random code units of type \p T. Random input
+/// contains plenty of malformed sequences.
+template <typename T> std::vector<T> random_units (std::size_t size, std::uint_least32_t max) {
+  std::mt19937 generator{size};
+  std::uniform_int_distribution<std::uint_least32_t> distribution{0, max};
+  std::vector<T> result (size);
+  std::generate (result.begin (), result.end (), [&] () { return static_cast<T> (distribution (generator)); });
+  return result;
+}
+
+/// Transcodes [first, last) using a single transcoder.
+template <typename From, typename To> std::vector<To> serial (std::vector<From> const& in, bool* well_formed) {
+  std::vector<To> out;
+  icubaby::transcoder<From, To> t;
+  t.end_cp (std::copy (in.begin (), in.end (), icubaby::iterator{&t, std::back_inserter (out)}));
+  *well_formed = t.well_formed ();
+  return out;
+}
+
+template <typename From, typename To> void check (std::vector<From> const& in) {
+  auto expected_well_formed = false;
+  auto const expected = serial<From, To> (in, &expected_well_formed);
+  std::vector<To> actual (in.size () * icubaby::longest_sequence_v<To>);
+  auto const res = icubaby::transcode<From, To> (small_chunks, in.data (), in.data () + in.size (), actual.begin ());
+  actual.erase (res.out, actual.end ());
+  EXPECT_THAT (actual, ElementsAreArray (expected));
+  EXPECT_EQ (res.well_formed, expected_well_formed);
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (ParallelTranscode, Utf8WellFormed) {
+  std::vector<icubaby::char8> in;
+  auto const code_points = random_units<char32_t> (4096, icubaby::max_code_point);
+  icubaby::t32_8 t;
+  t.end_cp (std::copy (code_points.begin (), code_points.end (), icubaby::iterator{&t, std::back_inserter (in)}));
+  check<icubaby::char8, char16_t> (in);
+  check<icubaby::char8, char32_t> (in);
+}
+// NOLINTNEXTLINE
+TEST (ParallelTranscode, Utf8NoAscii) {
+  // U+3053 HIRAGANA LETTER KO repeated: there are no ASCII code units to split on.
+  std::vector<icubaby::char8> in;
+  for (auto ctr = 0; ctr < 1000; ++ctr) {
+    for (auto const cu : {0xE3, 0x81, 0x93}) {
+      in.push_back (static_cast<icubaby::char8> (cu));
+    }
+  }
+  check<icubaby::char8, char16_t> (in);
+}
+// NOLINTNEXTLINE
+TEST (ParallelTranscode, Utf8Random) {
+  auto const in = random_units<icubaby::char8> (10000, 0xFF);
+  check<icubaby::char8, icubaby::char8> (in);
+  check<icubaby::char8, char16_t> (in);
+  check<icubaby::char8, char32_t> (in);
+}
+// NOLINTNEXTLINE
+TEST (ParallelTranscode, Utf16Random) {
+  // Choose values from a small range around the surrogates so that there are
+  // plenty of (possibly mismatched) surrogate pairs.
+  auto in = random_units<char16_t> (10000, 0x3FF);
+  std::transform (in.begin (), in.end (), in.begin (), [] (char16_t c) { return static_cast<char16_t> (c + 0xD700); });
+  check<char16_t, icubaby::char8> (in);
+  check<char16_t, char32_t> (in);
+}
+// NOLINTNEXTLINE
+TEST (ParallelTranscode, Utf32Random) {
+  auto const in = random_units<char32_t> (10000, 0x11FFFF);
+  check<char32_t, icubaby::char8> (in);
+  check<char32_t, char16_t> (in);
+}
+// NOLINTNEXTLINE
+TEST (ParallelTranscode, Empty) {
+  std::vector<char16_t> const in;
+  std::vector<icubaby::char8> out;
+  auto const res = icubaby::transcode<char16_t, icubaby::char8> (icubaby::par, in.data (), in.data (), out.begin ());
+  EXPECT_EQ (res.out, out.begin ());
+  EXPECT_TRUE (res.well_formed);
+}
+
+// NOLINTNEXTLINE
+TEST (ParallelFor, RethrowsWorkerException) {
+  std::vector<int> visited (4);
+  // The exception is thrown by a worker thread and must reach the caller
+  // rather than terminating the program.
+  EXPECT_THROW (icubaby::details::parallel_for (visited.size (),
+                                                [&visited] (std::size_t i) {
+                                                  visited[i] = 1;
+                                                  if (i == 3U) {
+                                                    throw std::runtime_error{"worker"};
+                                                  }
+                                                }),
+                std::runtime_error);
+  // All of the other calls still ran to completion.
+  EXPECT_THAT (visited, testing::Each (1));
+}
+
+// NOLINTNEXTLINE
+TEST (WorkQueues, OwnerTakesLargestThiefTakesSmallest) {
+  // Tasks are pushed largest first. The owner runs them in that order while a
+  // thief takes the smallest that remains.
+  icubaby::details::work_queues<int> queues{2};
+  for (auto const task : {30, 20, 10}) {
+    queues.push (0, task);
+  }
+  EXPECT_EQ (queues.pop (0), std::optional<int>{30});
+  EXPECT_EQ (queues.pop (1), std::optional<int>{10});
+  EXPECT_EQ (queues.pop (0), std::optional<int>{20});
+  EXPECT_EQ (queues.pop (1), std::nullopt);
+}
+
+// NOLINTNEXTLINE
+TEST (ParallelLength, MatchesSerial) {
+  auto const in8 = random_units<icubaby::char8> (10001, 0xFF);
+  EXPECT_EQ (icubaby::length (small_chunks, in8.data (), in8.data () + in8.size ()),
+             icubaby::length (in8.begin (), in8.end ()));
+  auto const in16 = random_units<char16_t> (10001, 0xFFFF);
+  EXPECT_EQ (icubaby::length (small_chunks, in16.data (), in16.data () + in16.size ()),
+             icubaby::length (in16.begin (), in16.end ()));
+}
+
+// NOLINTNEXTLINE
+TEST (ParallelIsWellFormed, Valid) {
+  std::vector<icubaby::char8> in;
+  auto const code_points = random_units<char32_t> (4096, icubaby::max_code_point);
+  icubaby::t32_8 t;
+  t.end_cp (std::copy (code_points.begin (), code_points.end (), icubaby::iterator{&t, std::back_inserter (in)}));
+  // Any surrogates in the random input were replaced by U+FFFD so the UTF-8 is well formed.
+  EXPECT_TRUE (icubaby::is_well_formed (small_chunks, in.data (), in.data () + in.size ()));
+  EXPECT_TRUE (icubaby::is_well_formed (in.data (), in.data () + in.size ()));
+}
+// NOLINTNEXTLINE
+TEST (ParallelIsWellFormed, Invalid) {
+  std::vector<icubaby::char8> in (10000, static_cast<icubaby::char8> ('a'));
+  // A truncated sequence at the very end.
+  in.back () = static_cast<icubaby::char8> (0xE3);
+  EXPECT_FALSE (icubaby::is_well_formed (small_chunks, in.data (), in.data () + in.size ()));
+  // A stray continuation byte in the middle.
+  in.back () = static_cast<icubaby::char8> ('a');
+  EXPECT_TRUE (icubaby::is_well_formed (small_chunks, in.data (), in.data () + in.size ()));
+  in[in.size () / 2] = static_cast<icubaby::char8> (0x80);
+  EXPECT_FALSE (icubaby::is_well_formed (small_chunks, in.data (), in.data () + in.size ()));
+}
+
+// NOLINTNEXTLINE
+TEST (ParallelTranscodeJobs, MatchesSerial) {
+  // A mixture of tiny, empty, and large jobs. The large ones are split between threads.
+  std::vector<std::vector<icubaby::char8>> inputs;
+  for (auto const size : {10000U, 3U, 0U, 200U, 5000U, 1U, 64U, 129U}) {
+    inputs.push_back (random_units<icubaby::char8> (size, 0xFF));
+  }
+  std::vector<icubaby::char8> well_formed (1000, static_cast<icubaby::char8> ('a'));
+  inputs.push_back (well_formed);
+
+  std::vector<icubaby::transcode_job<icubaby::char8, char16_t>> jobs;
+  for (auto const& in : inputs) {
+    jobs.push_back ({in.data (), in.data () + in.size (), {}, true});
+  }
+  icubaby::transcode_jobs<icubaby::char8, char16_t> (small_chunks, jobs.begin (), jobs.end ());
+  for (auto index = std::size_t{0}; index < inputs.size (); ++index) {
+    auto expected_well_formed = false;
+    auto const expected = serial<icubaby::char8, char16_t> (inputs[index], &expected_well_formed);
+    EXPECT_THAT (jobs[index].output, ElementsAreArray (expected)) << "Job " << index;
+    EXPECT_EQ (jobs[index].well_formed, expected_well_formed) << "Job " << index;
+  }
+}
+// NOLINTNEXTLINE
+TEST (ParallelTranscodeJobs, NoJobs) {
+  std::vector<icubaby::transcode_job<char32_t, icubaby::char8>> jobs;
+  icubaby::transcode_jobs<char32_t, icubaby::char8> (icubaby::par, jobs.begin (), jobs.end ());
+  EXPECT_TRUE (jobs.empty ());
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,210 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/rope.hpp"
+
+// Google Test
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+using string8 = std::basic_string<icubaby::char8>;
+
+/// Returns a string of \p count code points drawn from a mixture of one, two,
+/// three, and four byte sequences.
+string8 make_text (std::size_t count, std::size_t seed) {
+  static std::array<std::array<unsigned, 4>, 5> const samples{{
+      {0x61},                    // U+0061 LATIN SMALL LETTER A
+      {0xC3, 0xA9},              // U+00E9 LATIN SMALL LETTER E WITH ACUTE
+      {0xE3, 0x81, 0x93},        // U+3053 HIRAGANA LETTER KO
+      {0xF0, 0x9F, 0x98, 0x80},  // U+1F600 GRINNING FACE
+      {0x0A},                    // U+000A LINE FEED
+  }};
+  string8 result;
+  for (auto ctr = std::size_t{0}; ctr < count; ++ctr) {
+    for (auto const cu : samples[(seed + ctr * ctr) % samples.size ()]) {
+      if (cu != 0U) {
+        result += static_cast<icubaby::char8> (cu);
+      }
+    }
+  }
+  return result;
+}
+
+/// Checks that the chunks of \p r are divided at code point starts and that,
+/// unless there is only one, each holds at least min_chunk_size code units.
+void check_chunks (icubaby::rope const& r) {
+  std::vector<std::size_t> sizes;
+  r.for_each_chunk ([&sizes] (icubaby::char8 const* first, icubaby::char8 const* last) {
+    EXPECT_TRUE (sizes.empty () || icubaby::is_code_point_start (*first));
+    sizes.push_back (static_cast<std::size_t> (last - first));
+  });
+  for (auto const size : sizes) {
+    EXPECT_GT (size, 0U);
+    EXPECT_LE (size, icubaby::rope::max_chunk_size);
+    if (sizes.size () > 1U) {
+      EXPECT_GE (size, icubaby::rope::min_chunk_size);
+    }
+  }
+}
+
+void check (icubaby::rope const& r, string8 const& expected) {
+  ASSERT_EQ (r.str (), expected);
+  check_chunks (r);
+  icubaby::utf8_offset_map const map{expected.data (), expected.data () + expected.size ()};
+  EXPECT_EQ (r.end (), map.end ());
+  for (auto pos = std::size_t{0}; pos <= map.end ().utf16; pos += 7U) {
+    EXPECT_EQ (r.from_utf16 (pos), map.from_utf16 (pos)) << "pos=" << pos;
+    EXPECT_EQ (r.from_utf8 (pos), map.from_utf8 (pos)) << "pos=" << pos;
+    EXPECT_EQ (r.from_code_point (pos), map.from_code_point (pos)) << "pos=" << pos;
+  }
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (Rope, Empty) {
+  icubaby::rope const r;
+  EXPECT_TRUE (r.empty ());
+  EXPECT_EQ (r.end (), icubaby::rope::position{});
+  EXPECT_EQ (r.from_code_point (3), icubaby::rope::position{});
+  EXPECT_TRUE (r.str ().empty ());
+}
+// NOLINTNEXTLINE
+TEST (Rope, LargeText) {
+  auto const text = make_text (5000, 1);
+  icubaby::rope const r{text.data (), text.data () + text.size ()};
+  auto chunks = std::size_t{0};
+  r.for_each_chunk ([&chunks] (icubaby::char8 const* first, icubaby::char8 const* last) {
+    EXPECT_LE (static_cast<std::size_t> (last - first), icubaby::rope::max_chunk_size);
+    EXPECT_TRUE (icubaby::is_code_point_start (*first));
+    ++chunks;
+  });
+  EXPECT_GT (chunks, 1U);
+  check (r, text);
+}
+// NOLINTNEXTLINE
+TEST (Rope, Edits) {
+  auto text = make_text (3000, 2);
+  icubaby::rope r{text.data (), text.data () + text.size ()};
+  for (auto ctr = std::size_t{0}; ctr < 200; ++ctr) {
+    auto const length = r.end ().code_point;
+    auto const pos = (ctr * 7919U) % (length + 1U);
+    auto const offset = r.from_code_point (pos).utf8;
+    if (ctr % 3U == 2U) {
+      auto const count = ctr % 50U;
+      r.erase (pos, count);
+      icubaby::utf8_offset_map const map{text.data (), text.data () + text.size ()};
+      text.erase (offset, map.from_code_point (pos + count).utf8 - offset);
+    } else {
+      auto const insertion = make_text (ctr % 3U == 0U ? 1U : ctr * 5U, ctr);
+      r.insert (pos, insertion.data (), insertion.data () + insertion.size ());
+      text.insert (offset, insertion);
+    }
+    ASSERT_EQ (r.str (), text) << "edit " << ctr;
+    check_chunks (r);
+  }
+  check (r, text);
+
+  // A copy is independent of the original.
+  auto copy = r;
+  copy.erase (0, 10);
+  check (r, text);
+}
+
+// NOLINTNEXTLINE
+TEST (Rope, TypeAndErase) {
+  // Type a code point at a time and then erase piecemeal from the middle. The
+  // chunks created by each split must be combined with their neighbours.
+  auto const text = make_text (2000, 3);
+  icubaby::rope r;
+  icubaby::utf8_offset_map const map{text.data (), text.data () + text.size ()};
+  for (auto cp = std::size_t{0}; cp < map.end ().code_point; ++cp) {
+    auto const first = map.from_code_point (cp).utf8;
+    auto const last = map.from_code_point (cp + 1U).utf8;
+    r.insert (cp, text.data () + first, text.data () + last);
+  }
+  check (r, text);
+  auto expected = text;
+  while (r.end ().code_point > 100U) {
+    auto const pos = r.end ().code_point / 3U;
+    icubaby::utf8_offset_map const m{expected.data (), expected.data () + expected.size ()};
+    auto const offset = m.from_code_point (pos).utf8;
+    expected.erase (offset, m.from_code_point (pos + 37U).utf8 - offset);
+    r.erase (pos, 37U);
+    check_chunks (r);
+  }
+  check (r, expected);
+  auto chunks = std::size_t{0};
+  r.for_each_chunk ([&chunks] (icubaby::char8 const*, icubaby::char8 const*) { ++chunks; });
+  EXPECT_EQ (chunks, 1U);
+}
+// NOLINTNEXTLINE
+TEST (Rope, CodePointAcrossEdits) {
+  auto const u8 = [] (unsigned c) { return static_cast<icubaby::char8> (c); };
+  // U+3053 HIRAGANA LETTER KO inserted in two parts: the continuation code
+  // unit joins the code point at the end of the existing chunk.
+  string8 text (10, u8 ('a'));
+  text += u8 (0xE3);
+  text += u8 (0x81);
+  icubaby::rope r{text.data (), text.data () + text.size ()};
+  EXPECT_EQ (r.end ().code_point, 11U);
+  auto const tail = string8{u8 (0x93), u8 ('b')};
+  r.insert (r.end ().code_point, tail.data (), tail.data () + tail.size ());
+  text += tail;
+  check (r, text);
+  EXPECT_EQ (r.end ().code_point, 12U);
+
+  // The same but with chunks which are too large to be combined.
+  string8 big (icubaby::rope::max_chunk_size - 2U, u8 ('a'));
+  big += u8 (0xE3);
+  big += u8 (0x81);
+  icubaby::rope r2{big.data (), big.data () + big.size ()};
+  string8 more (icubaby::rope::max_chunk_size / 2U, u8 ('b'));
+  more.front () = u8 (0x93);
+  r2.insert (r2.end ().code_point, more.data (), more.data () + more.size ());
+  big += more;
+  check (r2, big);
+
+  // A lead code unit inserted before the continuation code units which start
+  // the text.
+  string8 cont (1000, u8 ('d'));
+  cont[0] = u8 (0x81);
+  cont[1] = u8 (0x93);
+  icubaby::rope r3{cont.data (), cont.data () + cont.size ()};
+  string8 lead (1000, u8 ('c'));
+  lead.back () = u8 (0xE3);
+  r3.insert (0, lead.data (), lead.data () + lead.size ());
+  check (r3, lead + cont);
+  EXPECT_EQ (r3.end ().code_point, 1998U);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,202 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::ElementsAre;
+using testing::ElementsAreArray;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+namespace {
+
+/// Encodes the UTF-32 string \p str as bytes using encoding \p enc.
+std::vector<std::uint8_t> as_bytes (std::u32string const& str, icubaby::encoding enc) {
+  std::vector<std::uint8_t> result;
+  auto append = [&result] (std::uint_least32_t unit, unsigned size, bool big_endian) {
+    for (auto ctr = 0U; ctr < size; ++ctr) {
+      auto const shift = 8U * (big_endian ? size - ctr - 1U : ctr);
+      result.push_back (static_cast<std::uint8_t> (unit >> shift));
+    }
+  };
+  switch (enc) {
+  case icubaby::encoding::unknown:
+  case icubaby::encoding::utf8: {
+    icubaby::t32_8 t;
+    std::vector<icubaby::char8> out;
+    t.end_cp (std::copy (str.begin (), str.end (), icubaby::iterator{&t, std::back_inserter (out)}));
+    std::transform (out.begin (), out.end (), std::back_inserter (result),
+                    [] (icubaby::char8 c) { return static_cast<std::uint8_t> (c); });
+  } break;
+  case icubaby::encoding::utf16be:
+  case icubaby::encoding::utf16le: {
+    icubaby::t32_16 t;
+    std::u16string out;
+    t.end_cp (std::copy (str.begin (), str.end (), icubaby::iterator{&t, std::back_inserter (out)}));
+    for (auto const c : out) {
+      append (c, 2U, enc == icubaby::encoding::utf16be);
+    }
+  } break;
+  case icubaby::encoding::utf32be:
+  case icubaby::encoding::utf32le:
+    for (auto const c : str) {
+      append (c, 4U, enc == icubaby::encoding::utf32be);
+    }
+    break;
+  }
+  return result;
+}
+
+std::u32string const hello = U"Hello, world! \U0001F600 Grinning face.\n";
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (Sniff, ByteOrderMarks) {
+  using icubaby::encoding;
+  for (auto const enc :
+       {encoding::utf8, encoding::utf16be, encoding::utf16le, encoding::utf32be, encoding::utf32le}) {
+    auto const bytes = as_bytes (U"\uFEFFA", enc);
+    auto const [actual, bom_size] = icubaby::sniff (bytes.begin (), bytes.end ());
+    EXPECT_EQ (actual, enc);
+    EXPECT_EQ (bom_size, bytes.size () - as_bytes (U"A", enc).size ());
+  }
+}
+// NOLINTNEXTLINE
+TEST (Sniff, NoByteOrderMark) {
+  using icubaby::encoding;
+  for (auto const enc :
+       {encoding::utf8, encoding::utf16be, encoding::utf16le, encoding::utf32be, encoding::utf32le}) {
+    auto const bytes = as_bytes (hello, enc);
+    // Check both the contiguous (word at a time) and generic implementations.
+    auto const res1 = icubaby::sniff (bytes.data (), bytes.data () + bytes.size ());
+    EXPECT_EQ (res1.enc, enc);
+    EXPECT_EQ (res1.bom_size, 0U);
+    auto const res2 = icubaby::sniff (bytes.begin (), bytes.end ());
+    EXPECT_EQ (res2.enc, enc);
+    EXPECT_EQ (res2.bom_size, 0U);
+  }
+}
+// NOLINTNEXTLINE
+TEST (Sniff, Empty) {
+  std::array<std::uint8_t, 0> const empty{};
+  EXPECT_EQ (icubaby::sniff (empty.begin (), empty.end ()).enc, icubaby::encoding::utf8);
+}
+// NOLINTNEXTLINE
+TEST (Sniff, NotUtf8) {
+  std::array<std::uint8_t, 4> const bytes{{0x41, 0xC0, 0x80, 0x42}};
+  EXPECT_EQ (icubaby::sniff (bytes.begin (), bytes.end ()).enc, icubaby::encoding::unknown);
+}
+// NOLINTNEXTLINE
+TEST (Sniff, WindowEndsMidCodePoint) {
+  // The window ends part way through U+1F600 GRINNING FACE. That's fine.
+  auto const bytes = as_bytes (U"ABC\U0001F600", icubaby::encoding::utf8);
+  EXPECT_EQ (icubaby::sniff (bytes.begin (), bytes.end (), 5).enc, icubaby::encoding::utf8);
+}
+
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, AllEncodings) {
+  using icubaby::encoding;
+  for (auto const enc :
+       {encoding::utf8, encoding::utf16be, encoding::utf16le, encoding::utf32be, encoding::utf32le}) {
+    auto const bytes = as_bytes (hello, enc);
+    icubaby::byte_transcoder<char32_t> t{enc};
+    EXPECT_EQ (t.input_encoding (), enc);
+    std::u32string out;
+    auto it = icubaby::transcode (t, bytes.data (), bytes.data () + bytes.size (), std::back_inserter (out));
+    t.end_cp (it);
+    EXPECT_TRUE (t.well_formed ());
+    EXPECT_FALSE (t.partial ());
+    EXPECT_EQ (out, hello);
+  }
+}
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, Utf16ToUtf8) {
+  auto const bytes = as_bytes (U"\U0001F600", icubaby::encoding::utf16le);
+  icubaby::byte_transcoder<icubaby::char8> t{icubaby::encoding::utf16le};
+  std::vector<icubaby::char8> out;
+  auto it = icubaby::iterator{&t, std::back_inserter (out)};
+  for (auto const b : bytes) {
+    *(it++) = static_cast<std::byte> (b);
+  }
+  t.end_cp (it);
+  EXPECT_TRUE (t.well_formed ());
+  EXPECT_THAT (out, ElementsAre (static_cast<icubaby::char8> (0xF0), static_cast<icubaby::char8> (0x9F),
+                                 static_cast<icubaby::char8> (0x98), static_cast<icubaby::char8> (0x80)));
+}
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, TruncatedCodeUnit) {
+  std::array const bytes{std::byte{0x41}, std::byte{0x00}, std::byte{0x42}};
+  icubaby::byte_transcoder<char32_t> t{icubaby::encoding::utf16le};
+  std::u32string out;
+  auto it = icubaby::transcode (t, bytes.begin (), bytes.end (), std::back_inserter (out));
+  EXPECT_TRUE (t.partial ());
+  t.end_cp (it);
+  EXPECT_FALSE (t.well_formed ());
+  EXPECT_FALSE (t.partial ());
+  EXPECT_EQ (out, U"A\uFFFD");
+}
+// NOLINTNEXTLINE
+TEST (ByteTranscoder, UnknownIsUtf8) {
+  icubaby::byte_transcoder<char32_t> const t{icubaby::encoding::unknown};
+  EXPECT_EQ (t.input_encoding (), icubaby::encoding::utf8);
+}
+
+// NOLINTNEXTLINE
+TEST (Transcode, MatchesPerCodeUnit) {
+  // A mixture of ASCII runs, multi-byte sequences and malformed input. In
+  // particular, the ASCII 'A' following the truncated U+3053 sequence must be
+  // treated exactly as the transcoder itself would.
+  std::vector<icubaby::char8> in;
+  for (auto const c : std::string{"The quick brown fox jumps over the lazy dog"}) {
+    in.push_back (static_cast<icubaby::char8> (c));
+  }
+  for (auto const c : {0xE3, 0x81, 0x93, 0xE3, 0x81, 0x41, 0x42, 0x43, 0xF0, 0x9F, 0x98, 0x80, 0x80, 0x44}) {
+    in.push_back (static_cast<icubaby::char8> (c));
+  }
+
+  std::vector<char16_t> expected;
+  icubaby::t8_16 t1;
+  t1.end_cp (std::copy (in.begin (), in.end (), icubaby::iterator{&t1, std::back_inserter (expected)}));
+
+  std::vector<char16_t> actual;
+  icubaby::t8_16 t2;
+  t2.end_cp (icubaby::transcode (t2, in.data (), in.data () + in.size (), std::back_inserter (actual)));
+
+  EXPECT_THAT (actual, ElementsAreArray (expected));
+  EXPECT_EQ (t1.well_formed (), t2.well_formed ());
+  EXPECT_FALSE (t2.well_formed ());
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
@@ -0,0 +1,119 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+// icubaby itself.
+#include "icubaby/icubaby.hpp"
+
+// Google Test
+#include "gtest/gtest.h"
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+
+#if ICUBABY_HAVE_CONCEPTS
+// Latin-1 has no std::basic_string so it may be neither the input nor the output encoding.
+template <typename To, typename From>
+concept can_transcode_string = requires (std::basic_string_view<From> v) { icubaby::transcode_string<To> (v); };
+static_assert (can_transcode_string<char16_t, icubaby::char8>);
+static_assert (!can_transcode_string<icubaby::latin1, icubaby::char8>);
+#endif  // ICUBABY_HAVE_CONCEPTS
+
+// NOLINTNEXTLINE
+TEST (TranscodeString, AsciiBorrowed) {
+  icubaby::u8string const input (100, static_cast<icubaby::char8> ('a'));
+  icubaby::u8string_view const view{input};
+  bool well_formed = false;
+  auto const result = icubaby::transcode_string<icubaby::char8> (view, &well_formed);
+  EXPECT_TRUE (result.borrowed ());
+  EXPECT_TRUE (well_formed);
+  EXPECT_EQ (result.view ().data (), input.data ());
+  EXPECT_EQ (result.view ().size (), input.size ());
+}
+
+// NOLINTNEXTLINE
+TEST (TranscodeString, AsciiWidened) {
+  std::string const ascii = "The quick brown fox jumps over the lazy dog";
+  icubaby::u8string const input (ascii.begin (), ascii.end ());
+  auto u16 = icubaby::transcode_string<char16_t> (icubaby::u8string_view{input});
+  EXPECT_FALSE (u16.borrowed ());
+  EXPECT_EQ (u16.view (), std::u16string_view{u"The quick brown fox jumps over the lazy dog"});
+  auto const u32 = icubaby::transcode_string<char32_t> (icubaby::u8string_view{input});
+  EXPECT_FALSE (u32.borrowed ());
+  EXPECT_EQ (u32.view (), std::u32string_view{U"The quick brown fox jumps over the lazy dog"});
+  // And back again.
+  auto const u8 = icubaby::transcode_string<icubaby::char8> (u16.view ());
+  EXPECT_FALSE (u8.borrowed ());
+  EXPECT_EQ (u8.view (), icubaby::u8string_view{input});
+  EXPECT_EQ (std::move (u16).str (), std::u16string{u"The quick brown fox jumps over the lazy dog"});
+}
+
+// NOLINTNEXTLINE
+TEST (TranscodeString, NonAscii) {
+  // "caf\u00E9" followed by a lone continuation byte.
+  icubaby::u8string const input{static_cast<icubaby::char8> ('c'), static_cast<icubaby::char8> ('a'),
+                                static_cast<icubaby::char8> ('f'), static_cast<icubaby::char8> (0xC3),
+                                static_cast<icubaby::char8> (0xA9), static_cast<icubaby::char8> (0x80)};
+  bool well_formed = true;
+  auto const u32 = icubaby::transcode_string<char32_t> (icubaby::u8string_view{input}, &well_formed);
+  EXPECT_FALSE (u32.borrowed ());
+  EXPECT_FALSE (well_formed);
+  EXPECT_EQ (u32.view (), std::u32string_view{U"caf\u00E9\uFFFD"});
+
+  auto const u8 = icubaby::transcode_string<icubaby::char8> (icubaby::u8string_view{input.data (), 5U}, &well_formed);
+  EXPECT_FALSE (u8.borrowed ());
+  EXPECT_TRUE (well_formed);
+  EXPECT_EQ (u8.view (), (icubaby::u8string_view{input.data (), 5U}));
+}
+
+// NOLINTNEXTLINE
+TEST (TranscodeString, AsciiNarrowed) {
+  std::u32string const input (100, U'z');
+  bool well_formed = false;
+  auto const u8 = icubaby::transcode_string<icubaby::char8> (std::u32string_view{input}, &well_formed);
+  EXPECT_FALSE (u8.borrowed ());
+  EXPECT_TRUE (well_formed);
+  EXPECT_EQ (u8.view (), icubaby::u8string (100, static_cast<icubaby::char8> ('z')));
+}
+
+// NOLINTNEXTLINE
+TEST (TranscodeString, LongNonAscii) {
+  // A long ASCII run (which transcode() consumes a word at a time) around a
+  // single U+1F600 GRINNING FACE.
+  std::u32string input (200, U'a');
+  input.insert (100, 1, char32_t{0x1F600});
+  bool well_formed = false;
+  auto u8 = icubaby::transcode_string<icubaby::char8> (std::u32string_view{input}, &well_formed);
+  EXPECT_FALSE (u8.borrowed ());
+  EXPECT_TRUE (well_formed);
+  auto const str = std::move (u8).str ();
+  ASSERT_EQ (str.size (), 204U);
+  EXPECT_EQ (str.substr (0, 100), icubaby::u8string (100, static_cast<icubaby::char8> ('a')));
+  icubaby::u8string const grinning{static_cast<icubaby::char8> (0xF0), static_cast<icubaby::char8> (0x9F),
+                                   static_cast<icubaby::char8> (0x98), static_cast<icubaby::char8> (0x80)};
+  EXPECT_EQ (str.substr (100, 4), grinning);
+  EXPECT_EQ (str.substr (104), icubaby::u8string (100, static_cast<icubaby::char8> ('a')));
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
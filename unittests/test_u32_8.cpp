@@ -20,7 +20,10 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <array>
+#include <cstdint>
 #include <iterator>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -74,6 +77,48 @@ TEST (Utf32To8, LowestTwoByteSequence) {
   EXPECT_THAT (out, testing::ElementsAre (static_cast<icubaby::char8> (0xc2), static_cast<icubaby::char8> (0x80)));
 }
 
+// NOLINTNEXTLINE
+TEST (Utf32To8, WritePaddedMatchesOperator) {
+  std::vector<char32_t> const input{0x0000, 0x0041, 0x007F, 0x0080, 0x03B1, 0x07FF, 0x0800, 0x20AC,
+                                    icubaby::first_high_surrogate, icubaby::last_low_surrogate, 0xFFFF, 0x10000,
+                                    0x1F600, icubaby::max_code_point, icubaby::max_code_point + 1, 0xFFFFFFFF};
+  for (auto const c : input) {
+    icubaby::t32_8 expected_t;
+    std::vector<icubaby::char8> expected;
+    expected_t (c, std::back_inserter (expected));
+
+    icubaby::t32_8 t;
+    std::array<icubaby::char8, 4> out{};
+    auto* const end = t.write_padded (c, out.data ());
+    EXPECT_THAT (std::vector<icubaby::char8> (out.data (), end), testing::ContainerEq (expected))
+        << std::hex << static_cast<std::uint_least32_t> (c);
+    EXPECT_EQ (t.well_formed (), expected_t.well_formed ()) << std::hex << static_cast<std::uint_least32_t> (c);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST (Utf32To8, TranscodeBuffer) {
+  std::u32string input;
+  for (auto ctr = 0U; ctr < 64U; ++ctr) {
+    input += U"a\u00E9\u20AC\U0001F600";
+  }
+  input += icubaby::first_high_surrogate;
+
+  icubaby::t32_8 expected_t;
+  std::vector<icubaby::char8> expected;
+  icubaby::transcode (expected_t, input.begin (), input.end (), std::back_inserter (expected));
+
+  // An exactly sized buffer so that the last few code points must be written
+  // without padding.
+  icubaby::t32_8 t;
+  std::vector<icubaby::char8> out (expected.size ());
+  auto* const end = icubaby::transcode (t, input.data (), input.data () + input.size (), out.data (),
+                                        out.data () + out.size ());
+  EXPECT_EQ (end, out.data () + out.size ());
+  EXPECT_THAT (out, testing::ContainerEq (expected));
+  EXPECT_FALSE (t.well_formed ());
+}
+
 #if defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 201811L
 // NOLINTNEXTLINE
 TEST (Utf32To8, RangesCopy) {
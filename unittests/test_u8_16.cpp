@@ -0,0 +1,106 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <ranges>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <version>
+
+// icubaby itself
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#if defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 201811L
+// NOLINTNEXTLINE
+TEST (Utf8To16, RangesSizeHints) {
+  // U+3053 HIRAGANA LETTER KO, U+1F600 GRINNING FACE, U+0041 LATIN CAPITAL LETTER A, and a truncated sequence.
+  std::vector<char8_t> const in{0xE3, 0x81, 0x93, 0xF0, 0x9F, 0x98, 0x80, 0x41, 0xE3, 0x81};
+  auto const view = in | icubaby::ranges::transcode<char8_t, char16_t>;
+  std::u16string out;
+  out.reserve (view.exact_size ());
+  std::ranges::copy (view, std::back_inserter (out));
+  EXPECT_EQ (out, u"\u3053\U0001F600A\uFFFD");
+  EXPECT_EQ (view.exact_size (), out.size ());
+  EXPECT_GE (view.reserve_hint (), out.size ());
+
+  std::list<char8_t> const list_in{in.begin (), in.end ()};
+  auto const list_view = list_in | icubaby::ranges::transcode<char8_t, char16_t>;
+  EXPECT_EQ (list_view.exact_size (), out.size ());
+  EXPECT_EQ (list_view.reserve_hint (), in.size ());
+}
+// NOLINTNEXTLINE
+TEST (Utf8To16, RangesReverse) {
+  // U+0041 LATIN CAPITAL LETTER A, U+3053 HIRAGANA LETTER KO, U+1F600 GRINNING FACE, U+00E9 LATIN SMALL LETTER E
+  // WITH ACUTE.
+  std::vector<char8_t> const in{0x41, 0xE3, 0x81, 0x93, 0xF0, 0x9F, 0x98, 0x80, 0xC3, 0xA9};
+  auto const view = in | icubaby::ranges::transcode<char8_t, char16_t>;
+  static_assert (std::ranges::bidirectional_range<decltype (view)>);
+  std::u16string reversed;
+  std::ranges::copy (view | std::views::reverse, std::back_inserter (reversed));
+  EXPECT_EQ (reversed, u"\u00E9\xDE00\xD83D\u3053A");
+
+  // Walk backwards from the end of the view.
+  auto it = view.end ();
+  std::u16string tail;
+  for (auto ctr = 0; ctr < 3; ++ctr) {
+    tail.insert (tail.begin (), *--it);
+  }
+  EXPECT_EQ (tail, u"\U0001F600\u00E9");
+  EXPECT_EQ (std::ranges::distance (view.begin (), it), 2);
+}
+// NOLINTNEXTLINE
+TEST (Utf8To16, RangesIteratorSize) {
+  // Algorithms copy iterators freely so they should be small: two base-sized members (the
+  // current position and the parent view) plus the transcoder and its output.
+  std::vector<char8_t> const in;
+  auto const view = in | icubaby::ranges::transcode<char8_t, char16_t>;
+  EXPECT_LE (sizeof (view.begin ()), 2 * sizeof (void*) + 16);
+}
+// NOLINTNEXTLINE
+TEST (Utf8To16, RangesMultiPass) {
+  // U+3053 HIRAGANA LETTER KO, U+1F600 GRINNING FACE.
+  std::vector<char8_t> const in{0xE3, 0x81, 0x93, 0xF0, 0x9F, 0x98, 0x80};
+  auto const view = in | icubaby::ranges::transcode<char8_t, char16_t>;
+  using iterator = std::ranges::iterator_t<decltype (view)>;
+  static_assert (std::forward_iterator<iterator>);
+  static_assert (std::is_same_v<std::iter_reference_t<iterator>, char16_t>);
+  // The legacy category is input because operator* returns by value.
+  static_assert (std::is_same_v<std::iterator_traits<iterator>::iterator_category, std::input_iterator_tag>);
+
+  // A copy of an iterator is independent of the original.
+  auto const first = view.begin ();
+  auto second = first;
+  ++second;
+  EXPECT_EQ (*first, char16_t{0x3053});
+  EXPECT_EQ (*second, char16_t{0xD83D});
+  EXPECT_TRUE (std::ranges::equal (view, view));
+  EXPECT_EQ (std::ranges::distance (first, view.end ()), 3);
+  EXPECT_EQ (*first, char16_t{0x3053});
+}
+#endif  // __cpp_lib_ranges
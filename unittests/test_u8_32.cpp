@@ -23,8 +23,11 @@
 #include <algorithm>
 #include <array>
 #include <iterator>
+#include <list>
+#include <sstream>
 #include <ranges>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 #include <version>
@@ -261,6 +264,64 @@ TEST (Utf8To32, PartialEndCp) {
   EXPECT_THAT (out, ElementsAre (char32_t{0x1F0A6}, icubaby::replacement_char));
 }
 
+namespace {
+
+/// Decodes \p in with decoders using each of the DFA engines and checks that
+/// the results are identical.
+template <std::size_t Size> void check_engines (std::array<icubaby::char8, Size> const& in) {
+  icubaby::utf8_decoder<icubaby::table_dfa> table;
+  icubaby::utf8_decoder<icubaby::shift_dfa> shift;
+  std::array<char32_t, Size + 1> table_out{};
+  std::array<char32_t, Size + 1> shift_out{};
+  auto table_it = table_out.begin ();
+  auto shift_it = shift_out.begin ();
+  for (auto const cu : in) {
+    table_it = table (cu, table_it);
+    shift_it = shift (cu, shift_it);
+    ASSERT_EQ (table.partial (), shift.partial ());
+  }
+  table_it = table.end_cp (table_it);
+  shift_it = shift.end_cp (shift_it);
+  ASSERT_EQ (table.well_formed (), shift.well_formed ());
+  ASSERT_EQ (table_out, shift_out);
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (Utf8To32, ShiftDfaMatchesTable) {
+  for (auto b0 = 0U; b0 < 256U; ++b0) {
+    for (auto b1 = 0U; b1 < 256U; ++b1) {
+      check_engines (std::array{static_cast<icubaby::char8> (b0), static_cast<icubaby::char8> (b1)});
+      if (b0 < 0xC0U) {
+        continue;
+      }
+      for (auto b2 = 0U; b2 < 256U; ++b2) {
+        check_engines (std::array{static_cast<icubaby::char8> (b0), static_cast<icubaby::char8> (b1),
+                                  static_cast<icubaby::char8> (b2)});
+        if (b0 >= 0xF0U && b0 <= 0xF4U && (b2 & 0xC0U) == 0x80U && b1 % 16U == 0U) {
+          for (auto b3 = 0U; b3 < 256U; ++b3) {
+            check_engines (std::array{static_cast<icubaby::char8> (b0), static_cast<icubaby::char8> (b1),
+                                      static_cast<icubaby::char8> (b2), static_cast<icubaby::char8> (b3)});
+          }
+        }
+      }
+    }
+  }
+}
+// NOLINTNEXTLINE
+TEST (Utf8To32, ShiftDfaIterator) {
+  icubaby::utf8_decoder<icubaby::shift_dfa> d;
+  std::vector<char32_t> out;
+  auto it = icubaby::iterator{&d, std::back_inserter (out)};
+  for (auto const cu : {0x41, 0xF0, 0x9F, 0x82, 0xA6, 0xE3}) {
+    *(it++) = static_cast<icubaby::char8> (cu);
+  }
+  it = d.end_cp (it);
+  EXPECT_FALSE (d.well_formed ());
+  EXPECT_THAT (out, ElementsAre (char32_t{0x41}, char32_t{0x1F0A6}, icubaby::replacement_char));
+}
+
 #if defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 201811L
 // NOLINTNEXTLINE
 TEST (Utf8To32, RangesCopy) {
@@ -281,4 +342,157 @@ TEST (Utf8To32, RangesCopy) {
   EXPECT_THAT (out32, testing::ElementsAre (char32_t{0x3053}, char32_t{0x3093}, char32_t{0x306B}, char32_t{0x3061},
                                             char32_t{0x306F}, char32_t{0x4E16}, char32_t{0x754C}, char32_t{0x000A}));
 }
+// NOLINTNEXTLINE
+TEST (Utf8To32, RangesCopyBuffered) {
+  std::vector<char8_t> in;
+  for (auto ctr = 0; ctr < 50; ++ctr) {
+    // U+3053 HIRAGANA LETTER KO, U+0041 LATIN CAPITAL LETTER A, and a truncated sequence.
+    for (auto const cu : {0xE3, 0x81, 0x93, 0x41, 0xE3, 0x81}) {
+      in.push_back (static_cast<char8_t> (cu));
+    }
+  }
+  std::vector<char32_t> expected;
+  icubaby::t8_32 t;
+  t.end_cp (std::copy (in.begin (), in.end (), icubaby::iterator{&t, std::back_inserter (expected)}));
+
+  std::vector<char32_t> unbuffered;
+  std::ranges::copy (in | icubaby::ranges::transcode<char8_t, char32_t>, std::back_inserter (unbuffered));
+  EXPECT_THAT (unbuffered, testing::ElementsAreArray (expected));
+
+  std::vector<char32_t> out32;
+  auto const view = in | icubaby::ranges::transcode<char8_t, char32_t, icubaby::ranges::buffered<16>>;
+  auto it = view.begin ();
+  for (; it != view.end (); ++it) {
+    out32.push_back (*it);
+  }
+  EXPECT_THAT (out32, testing::ElementsAreArray (expected));
+  EXPECT_FALSE (it.well_formed ());
+}
+// NOLINTNEXTLINE
+TEST (Utf8To32, RangesCopyBufferedNonContiguous) {
+  // A list isn't contiguous so the view cannot use the bulk transcoder.
+  std::list<char8_t> in;
+  for (auto ctr = 0; ctr < 50; ++ctr) {
+    for (auto const cu : {0xE3, 0x81, 0x93, 0x41, 0x42, 0xF0}) {
+      in.push_back (static_cast<char8_t> (cu));
+    }
+  }
+  std::vector<char32_t> expected;
+  icubaby::t8_32 t;
+  t.end_cp (std::copy (in.begin (), in.end (), icubaby::iterator{&t, std::back_inserter (expected)}));
+
+  std::vector<char32_t> out32;
+  std::ranges::copy (in | icubaby::ranges::transcode<char8_t, char32_t, icubaby::ranges::buffered<16>>,
+                     std::back_inserter (out32));
+  EXPECT_THAT (out32, testing::ElementsAreArray (expected));
+}
+// NOLINTNEXTLINE
+TEST (Utf8To32, RangesCopyBufferedAscii) {
+  std::u8string const str (1000, u8'a');
+  std::u8string_view const in{str};
+  std::vector<char32_t> out32;
+  std::ranges::copy (in | icubaby::ranges::transcode<char8_t, char32_t, icubaby::ranges::buffered<256>>,
+                     std::back_inserter (out32));
+  EXPECT_EQ (out32, std::vector<char32_t> (1000, U'a'));
+}
+// NOLINTNEXTLINE
+TEST (Utf8To32, RangesTruncatedEnd) {
+  // U+0041 LATIN CAPITAL LETTER A followed by a truncated three byte sequence. The final
+  // REPLACEMENT CHARACTER must be produced exactly once however the view is buffered.
+  std::list<char8_t> const in{0x41, 0xE3, 0x81};
+  auto const check = [] (auto const& view) {
+    std::u32string out;
+    auto it = view.begin ();
+    for (; it != view.end (); ++it) {
+      out += *it;
+    }
+    EXPECT_EQ (out, U"A\uFFFD");
+    EXPECT_FALSE (it.well_formed ());
+  };
+  check (in | icubaby::ranges::transcode<char8_t, char32_t>);
+  check (in | icubaby::ranges::transcode<char8_t, char32_t, icubaby::ranges::buffered<16>>);
+}
+// NOLINTNEXTLINE
+TEST (Utf8To32, RangesNullTerminated) {
+  char8_t const* const str = u8"A\u3053\U0001F600";
+  std::vector<char32_t> out32;
+  auto const view =
+      std::ranges::subrange{str, icubaby::null_terminated} | icubaby::ranges::transcode<char8_t, char32_t>;
+  std::ranges::copy (view, std::back_inserter (out32));
+  EXPECT_THAT (out32, testing::ElementsAre (char32_t{0x41}, char32_t{0x3053}, char32_t{0x1F600}));
+}
+// NOLINTNEXTLINE
+TEST (Utf8To32, RangesFusion) {
+  // U+3053 HIRAGANA LETTER KO, U+1F600 GRINNING FACE, a stray continuation byte, and a truncated sequence.
+  std::vector<char8_t> const in{0xE3, 0x81, 0x93, 0xF0, 0x9F, 0x98, 0x80, 0x80, 0x41, 0xE3, 0x81};
+  auto const view = in | icubaby::ranges::transcode<char8_t, char16_t> | icubaby::ranges::transcode<char16_t, char32_t>;
+  using fused_view =
+      icubaby::ranges::transcode_view<char8_t, char32_t, std::ranges::ref_view<std::vector<char8_t> const>>;
+  static_assert (std::is_same_v<std::remove_const_t<decltype (view)>, fused_view>);
+  std::vector<char32_t> out32;
+  auto it = view.begin ();
+  for (; it != view.end (); ++it) {
+    out32.push_back (*it);
+  }
+  EXPECT_THAT (out32, testing::ElementsAre (char32_t{0x3053}, char32_t{0x1F600}, icubaby::replacement_char,
+                                            char32_t{0x41}, icubaby::replacement_char));
+  // Unlike the chain, the fused view reports the errors in the original input.
+  EXPECT_FALSE (it.well_formed ());
+
+  // Views with differing buffering policies are not fused.
+  auto const chain = in | icubaby::ranges::transcode<char8_t, char16_t, icubaby::ranges::buffered<16>> |
+                     icubaby::ranges::transcode<char16_t, char32_t>;
+  static_assert (!std::is_same_v<std::remove_const_t<decltype (chain)>, fused_view>);
+  std::vector<char32_t> chain32;
+  std::ranges::copy (chain, std::back_inserter (chain32));
+  EXPECT_THAT (chain32, testing::ElementsAreArray (out32));
+}
+// NOLINTNEXTLINE
+TEST (Utf8To32, RangesInputRange) {
+  // Enough input to need several blocks with multi-byte sequences that straddle the block boundaries.
+  std::string str;
+  for (auto ctr = 0; ctr < 200; ++ctr) {
+    str += "A\xE3\x81\x93";  // U+0041 LATIN CAPITAL LETTER A, U+3053 HIRAGANA LETTER KO
+  }
+  str += "\xE3\x81";  // A truncated sequence.
+  std::vector<char32_t> expected;
+  icubaby::t8_32 t;
+  t.end_cp (std::copy (str.begin (), str.end (), icubaby::iterator{&t, std::back_inserter (expected)}));
+
+  auto const check = [&str, &expected] (auto adaptor) {
+    std::istringstream is{str};
+    auto view = std::ranges::subrange{std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}} | adaptor;
+    static_assert (std::ranges::input_range<decltype (view)> && !std::ranges::forward_range<decltype (view)>);
+    std::vector<char32_t> out32;
+    auto it = view.begin ();
+    for (; it != view.end (); ++it) {
+      out32.push_back (*it);
+    }
+    EXPECT_THAT (out32, testing::ElementsAreArray (expected));
+    EXPECT_FALSE (it.well_formed ());
+  };
+  check (icubaby::ranges::transcode<char8_t, char32_t>);
+  check (icubaby::ranges::transcode<char8_t, char32_t, icubaby::ranges::buffered<64>>);
+}
+// NOLINTNEXTLINE
+TEST (Utf8To32, RangesInputStreaming) {
+  // U+0041 LATIN CAPITAL LETTER A, U+3053 HIRAGANA LETTER KO, U+0042 LATIN CAPITAL LETTER B. An
+  // unbuffered view must not read beyond the code point that it yields: an interactive source
+  // would block waiting for input.
+  std::istringstream is{"A\xE3\x81\x93" "B"};
+  auto view = std::ranges::subrange{std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}} |
+              icubaby::ranges::transcode<char8_t, char32_t>;
+  auto it = view.begin ();
+  EXPECT_EQ (*it, U'A');
+  EXPECT_EQ (static_cast<std::streamoff> (is.tellg ()), 1);
+  ++it;
+  EXPECT_EQ (*it, char32_t{0x3053});
+  EXPECT_EQ (static_cast<std::streamoff> (is.tellg ()), 4);
+  ++it;
+  EXPECT_EQ (*it, U'B');
+  EXPECT_EQ (static_cast<std::streamoff> (is.tellg ()), 5);
+  ++it;
+  EXPECT_TRUE (it == view.end ());
+  EXPECT_TRUE (it.well_formed ());
+}
 #endif  // __cpp_lib_ranges
@@ -0,0 +1,64 @@
+// MIT License
+//
+// Copyright (c) 2022 Paul Bowen-Huggett
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <vector>
+#include <version>
+
+// icubaby itself
+#include "icubaby/icubaby.hpp"
+
+// Google Test/Mock
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#if defined(__cpp_lib_ranges) && __cpp_lib_ranges >= 201811L
+// NOLINTNEXTLINE
+TEST (Utf8To8, RangesPassThrough) {
+  std::vector<char8_t> in;
+  for (auto ctr = 0; ctr < 100; ++ctr) {
+    // U+0041 LATIN CAPITAL LETTER A, U+3053 HIRAGANA LETTER KO, U+1F600 GRINNING FACE.
+    for (auto const cu : {0x41, 0xE3, 0x81, 0x93, 0xF0, 0x9F, 0x98, 0x80}) {
+      in.push_back (static_cast<char8_t> (cu));
+    }
+    if (ctr % 10 == 9) {
+      in.push_back (0x80);  // A stray continuation byte.
+    }
+  }
+  in.push_back (0xE3);  // A truncated sequence.
+  std::vector<char8_t> expected;
+  icubaby::t8_8 t;
+  t.end_cp (std::copy (in.begin (), in.end (), icubaby::iterator{&t, std::back_inserter (expected)}));
+
+  std::vector<char8_t> out8;
+  std::ranges::copy (in | icubaby::ranges::transcode<char8_t, char8_t, icubaby::ranges::buffered<64>>,
+                     std::back_inserter (out8));
+  EXPECT_THAT (out8, testing::ElementsAreArray (expected));
+
+  // The unchecked policy passes the range through unchanged.
+  auto const unchecked = in | icubaby::ranges::transcode<char8_t, char8_t, icubaby::ranges::unchecked>;
+  static_assert (std::ranges::contiguous_range<decltype (unchecked)>);
+  EXPECT_TRUE (std::ranges::equal (unchecked, in));
+}
+#endif  // __cpp_lib_ranges
@@ -20,10 +20,13 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <array>
 #include <cstddef>
 #include <iterator>
 #include <limits>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 // icubaby itself.
@@ -239,3 +242,199 @@ TYPED_TEST (CjkUnifiedIdeographCodePoints, Index) {
 
   EXPECT_EQ (end, icubaby::index (begin, end, size_t{4}));
 }
+
+// NOLINTNEXTLINE
+TEST (IsWellFormed, Utf8) {
+  std::vector<icubaby::char8> cus{'H', 'e', 'l', 'l', 'o', static_cast<icubaby::char8> (0xE2),
+                                  static_cast<icubaby::char8> (0x82), static_cast<icubaby::char8> (0xAC)};
+  EXPECT_TRUE (icubaby::is_well_formed (cus.data (), cus.data () + cus.size ()));
+  EXPECT_TRUE (icubaby::is_well_formed (cus.begin (), cus.end ()));
+  // Drop the final byte of U+20AC EURO SIGN.
+  cus.pop_back ();
+  EXPECT_FALSE (icubaby::is_well_formed (cus.data (), cus.data () + cus.size ()));
+  EXPECT_FALSE (icubaby::is_well_formed (cus.begin (), cus.end ()));
+}
+// NOLINTNEXTLINE
+TEST (IsWellFormed, Utf16) {
+  std::u16string str = u"ab\U0001F600";
+  EXPECT_TRUE (icubaby::is_well_formed (str.begin (), str.end ()));
+  str.pop_back ();
+  EXPECT_FALSE (icubaby::is_well_formed (str.begin (), str.end ()));
+}
+// NOLINTNEXTLINE
+TEST (CodePointIndex, Utf8) {
+  std::vector<icubaby::char8> cus;
+  for (auto ctr = 0; ctr < 100; ++ctr) {
+    // A mixture of one, two, three, and four byte sequences with a stray continuation byte.
+    for (auto const cu : {0x41, 0xC3, 0xA9, 0xE3, 0x81, 0x93, 0xF0, 0x9F, 0x98, 0x80, 0x42, 0x43, 0x80}) {
+      cus.push_back (static_cast<icubaby::char8> (cu));
+    }
+  }
+  auto const* const first = cus.data ();
+  auto const* const last = first + cus.size ();
+  using index_type = icubaby::code_point_index<icubaby::char8>;
+  for (auto const stride : {std::size_t{1}, std::size_t{3}, std::size_t{64}, index_type::default_stride}) {
+    index_type const index{first, last, stride};
+    EXPECT_EQ (index.size (), static_cast<std::size_t> (icubaby::length (first, last)));
+    for (auto pos = std::size_t{0}; pos <= index.size () + 1U; ++pos) {
+      EXPECT_EQ (index.index (pos), icubaby::index (first, last, pos)) << "stride=" << stride << " pos=" << pos;
+    }
+    auto const sub = index.substr (5, 3);
+    EXPECT_EQ (sub.data (), icubaby::index (first, last, 5));
+    EXPECT_EQ (sub.data () + sub.size (), icubaby::index (first, last, 8));
+    // The final code point is followed by a stray continuation byte.
+    EXPECT_EQ (index.substr (index.size () - 1U, 10).size (), 2U);
+  }
+}
+// NOLINTNEXTLINE
+TEST (CodePointIndex, Utf16) {
+  std::u16string const str = u"a\U0001F600b\u3053c\U0001F600\U0001F600d";
+  auto const* const first = str.data ();
+  auto const* const last = first + str.size ();
+  icubaby::code_point_index<char16_t> const index{first, last, 2};
+  EXPECT_EQ (index.size (), 8U);
+  for (auto pos = std::size_t{0}; pos <= index.size (); ++pos) {
+    EXPECT_EQ (index.index (pos), icubaby::index (first, last, pos)) << "pos=" << pos;
+  }
+}
+// NOLINTNEXTLINE
+TEST (CodePointIndex, Empty) {
+  icubaby::code_point_index<char32_t> const index;
+  EXPECT_EQ (index.size (), 0U);
+  EXPECT_TRUE (index.substr (0, 1).empty ());
+}
+// NOLINTNEXTLINE
+TEST (Utf8OffsetMap, Lookup) {
+  // "a", U+00E9, U+3053, U+1F600, "b".
+  std::vector<icubaby::char8> cus;
+  for (auto ctr = 0; ctr < 50; ++ctr) {
+    for (auto const cu : {0x61, 0xC3, 0xA9, 0xE3, 0x81, 0x93, 0xF0, 0x9F, 0x98, 0x80, 0x62}) {
+      cus.push_back (static_cast<icubaby::char8> (cu));
+    }
+  }
+  using position = icubaby::utf8_offset_map::position;
+  // Compute the expected position of every code point.
+  std::vector<position> expected;
+  auto pos = position{};
+  for (auto ctr = 0; ctr < 50; ++ctr) {
+    for (auto const& [utf8, utf16] : {std::pair{1U, 1U}, std::pair{2U, 1U}, std::pair{3U, 1U}, std::pair{4U, 2U},
+                                      std::pair{1U, 1U}}) {
+      expected.push_back (pos);
+      pos.utf8 += utf8;
+      pos.utf16 += utf16;
+      pos.code_point += 1U;
+    }
+  }
+  auto const end = pos;
+
+  for (auto const stride : {std::size_t{1}, std::size_t{7}, icubaby::utf8_offset_map::default_stride}) {
+    icubaby::utf8_offset_map const map{cus.data (), cus.data () + cus.size (), stride};
+    EXPECT_EQ (map.end (), end);
+    for (auto const& p : expected) {
+      EXPECT_EQ (map.from_utf8 (p.utf8), p);
+      EXPECT_EQ (map.from_utf16 (p.utf16), p);
+      EXPECT_EQ (map.from_code_point (p.code_point), p);
+    }
+    EXPECT_EQ (map.from_utf8 (2), expected[1]);   // The middle of U+00E9.
+    EXPECT_EQ (map.from_utf8 (9), expected[3]);   // The middle of U+1F600.
+    EXPECT_EQ (map.from_utf16 (4), expected[3]);  // U+1F600's low surrogate.
+    EXPECT_EQ (map.from_utf8 (cus.size () + 10U), end);
+    EXPECT_EQ (map.from_utf16 (end.utf16), end);
+  }
+}
+// NOLINTNEXTLINE
+TEST (Utf8OffsetMap, Batch) {
+  std::string const str = "ab\xC3\xA9\xF0\x9F\x98\x80\xE3\x81\x93z";
+  auto const* const first = reinterpret_cast<icubaby::char8 const*> (str.data ());  // NOLINT
+  icubaby::utf8_offset_map const map{first, first + str.size (), 2};
+  std::vector<std::size_t> const offsets{0, 1, 1, 3, 4, 5, 6, 7, 8, 50};
+  std::vector<icubaby::utf8_offset_map::position> actual;
+  map.from_utf16 (std::begin (offsets), std::end (offsets), std::back_inserter (actual));
+  ASSERT_EQ (actual.size (), offsets.size ());
+  for (auto ctr = std::size_t{0}; ctr < offsets.size (); ++ctr) {
+    EXPECT_EQ (actual[ctr], map.from_utf16 (offsets[ctr])) << "offset=" << offsets[ctr];
+  }
+  actual.clear ();
+  map.from_utf8 (std::begin (offsets), std::end (offsets), std::back_inserter (actual));
+  for (auto ctr = std::size_t{0}; ctr < offsets.size (); ++ctr) {
+    EXPECT_EQ (actual[ctr], map.from_utf8 (offsets[ctr])) << "offset=" << offsets[ctr];
+  }
+  actual.clear ();
+  map.from_code_point (std::begin (offsets), std::end (offsets), std::back_inserter (actual));
+  for (auto ctr = std::size_t{0}; ctr < offsets.size (); ++ctr) {
+    EXPECT_EQ (actual[ctr], map.from_code_point (offsets[ctr])) << "offset=" << offsets[ctr];
+  }
+}
+
+namespace {
+
+/// Transcodes \p in using a transcoder of type \p Transcoder. Returns true if
+/// the output matches \p expected and the transcoder's well-formed state
+/// matches \p well_formed. Usable in constant expressions.
+template <typename Transcoder, typename InputType, std::size_t InSize, std::size_t OutSize>
+constexpr bool transcodes_to (std::array<InputType, InSize> const& in,
+                              std::array<typename Transcoder::output_type, OutSize> const& expected,
+                              bool well_formed = true) {
+  std::array<typename Transcoder::output_type, OutSize> out{};
+  Transcoder t;
+  auto pos = out.begin ();
+  for (auto const c : in) {
+    pos = t (c, pos);
+  }
+  pos = t.end_cp (pos);
+  if (pos != out.end () || t.well_formed () != well_formed) {
+    return false;
+  }
+  for (auto ctr = std::size_t{0}; ctr < OutSize; ++ctr) {
+    if (out[ctr] != expected[ctr]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // end anonymous namespace
+
+// NOLINTNEXTLINE
+TEST (Constexpr, Transcoders) {
+  // U+00E9 LATIN SMALL LETTER E WITH ACUTE, U+1F600 GRINNING FACE.
+  constexpr std::array<icubaby::char8, 6> utf8{
+      {static_cast<icubaby::char8> (0xC3), static_cast<icubaby::char8> (0xA9), static_cast<icubaby::char8> (0xF0),
+       static_cast<icubaby::char8> (0x9F), static_cast<icubaby::char8> (0x98), static_cast<icubaby::char8> (0x80)}};
+  constexpr std::array<char16_t, 3> utf16{{0x00E9, 0xD83D, 0xDE00}};
+  constexpr std::array<char32_t, 2> utf32{{0x00E9, 0x1F600}};
+
+  static_assert (transcodes_to<icubaby::t8_32> (utf8, utf32));
+  static_assert (transcodes_to<icubaby::t8_16> (utf8, utf16));
+  static_assert (transcodes_to<icubaby::t8_8> (utf8, utf8));
+  static_assert (transcodes_to<icubaby::t16_8> (utf16, utf8));
+  static_assert (transcodes_to<icubaby::t16_16> (utf16, utf16));
+  static_assert (transcodes_to<icubaby::t16_32> (utf16, utf32));
+  static_assert (transcodes_to<icubaby::t32_8> (utf32, utf8));
+  static_assert (transcodes_to<icubaby::t32_16> (utf32, utf16));
+  static_assert (transcodes_to<icubaby::t32_32> (utf32, utf32));
+
+  // A truncated sequence produces U+FFFD REPLACEMENT CHARACTER.
+  constexpr std::array<icubaby::char8, 2> truncated{
+      {static_cast<icubaby::char8> (0x41), static_cast<icubaby::char8> (0xE3)}};
+  static_assert (transcodes_to<icubaby::t8_32> (truncated, std::array<char32_t, 2>{{0x41, 0xFFFD}}, false));
+
+  constexpr std::array<std::byte, 4> bytes{{std::byte{0x41}, std::byte{0xC3}, std::byte{0xA9}, std::byte{0xE3}}};
+  static_assert (
+      transcodes_to<icubaby::byte_transcoder<char16_t>> (bytes, std::array<char16_t, 3>{{0x41, 0xE9, 0xFFFD}}, false));
+  EXPECT_TRUE (true);
+}
+
+#if ICUBABY_HAVE_CLASS_NTTP && ICUBABY_HAVE_CONCEPTS
+// NOLINTNEXTLINE
+TEST (Constexpr, Literal) {
+  constexpr auto hello = icubaby::literal<char16_t, u8"Hello, 世界 \U0001F600">;
+  static_assert (std::is_same_v<decltype (hello), std::array<char16_t, 12> const>);
+  EXPECT_EQ ((std::u16string{hello.begin (), hello.end ()}), u"Hello, 世界 \U0001F600");
+
+  constexpr auto utf8 = icubaby::literal<char8_t, U"é\U0001F600">;
+  static_assert (utf8 == std::array<char8_t, 6>{{0xC3, 0xA9, 0xF0, 0x9F, 0x98, 0x80}});
+  static_assert (transcodes_to<icubaby::t8_16> (utf8, icubaby::literal<char16_t, U"é\U0001F600">));
+  static_assert (icubaby::literal<char32_t, u"">.empty ());
+}
+#endif  // ICUBABY_HAVE_CLASS_NTTP && ICUBABY_HAVE_CONCEPTS